@@ -0,0 +1,60 @@
+#include "AsyncJobQueue.hpp"
+#include "Telemetry.hpp"
+
+#include <vector>
+
+AsyncJobQueue::AsyncJobQueue() {
+    this->worker = std::jthread([this](std::stop_token stop){ this->workLoop(stop); });
+}
+
+AsyncJobQueue::~AsyncJobQueue() {
+    this->worker.request_stop();
+}
+
+void AsyncJobQueue::submit(std::function<size_t()> prepare, std::function<size_t(uint32_t currentFrame)> finish) {
+    auto job = std::make_shared<Job>();
+    job->prepare = std::move(prepare);
+    job->finish = std::move(finish);
+
+    {
+        std::lock_guard lock(this->mutex);
+        this->jobs.push_back(job);
+        this->preparing.push_back(job);
+    }
+    this->workAvailable.notify_one();
+}
+
+void AsyncJobQueue::flush(uint32_t currentFrame) {
+    std::vector<std::shared_ptr<Job>> ready;
+    {
+        std::lock_guard lock(this->mutex);
+        size_t bytes = 0;
+        while(!this->jobs.empty() && this->jobs.front()->prepared) {
+            auto& job = this->jobs.front();
+            if(!ready.empty() && bytes + job->bytes > FRAME_BUDGET)
+                break;
+
+            bytes += job->bytes;
+            ready.push_back(std::move(job));
+            this->jobs.pop_front();
+        }
+    }
+
+    for(auto& job: ready)
+        Telemetry::add(Metric::BYTES_UPLOADED, job->finish(currentFrame));
+}
+
+void AsyncJobQueue::workLoop(std::stop_token stop) {
+    std::unique_lock lock(this->mutex);
+    while(this->workAvailable.wait(lock, stop, [this]{ return !this->preparing.empty(); })) {
+        auto job = std::move(this->preparing.front());
+        this->preparing.pop_front();
+
+        lock.unlock();
+        auto bytes = job->prepare();
+        lock.lock();
+
+        job->bytes = bytes;
+        job->prepared = true;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+
+//Runs the CPU side of jobs, like generating a mesh, on a worker thread and their main thread side in flush,
+//in submission order and up to a byte budget per frame so a frame doesn't stall on several big uploads.
+//It doesn't batch GPU work: every job does its own upload with its own staging and queue wait
+class AsyncJobQueue {
+public:
+    static constexpr size_t FRAME_BUDGET = 16 << 20; //Bytes, one job is always let through even if it's bigger
+
+public:
+    AsyncJobQueue();
+    ~AsyncJobQueue();
+
+    //prepare runs on the worker and returns the bytes finish expects to upload, which is what the budget counts.
+    //finish runs on the main thread and returns the bytes it really uploaded, 0 if it had nothing left to do
+    void submit(std::function<size_t()> prepare, std::function<size_t(uint32_t currentFrame)> finish);
+
+    //Must be called once per frame from the main thread
+    void flush(uint32_t currentFrame);
+
+private:
+    struct Job {
+        std::function<size_t()> prepare;
+        std::function<size_t(uint32_t)> finish;
+        size_t bytes = 0;
+        bool prepared = false;
+    };
+
+    std::deque<std::shared_ptr<Job>> jobs, preparing;
+    std::mutex mutex;
+    std::condition_variable_any workAvailable;
+
+    std::jthread worker;
+
+private:
+    void workLoop(std::stop_token stop);
+
+};
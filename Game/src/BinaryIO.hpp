@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <type_traits>
+
+//Small helpers shared by the binary caches and save files, every file is little endian as it's written by the host
+
+namespace bin {
+
+    inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        for(size_t i=0; i<size; ++i) {
+            hash ^= bytes[i];
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    inline uint64_t hashFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary);
+        if(!file.is_open())
+            throw std::runtime_error("failed to open file " + path.string());
+
+        std::vector<char> buffer(1 << 16);
+        uint64_t hash = fnv1a(nullptr, 0);
+        while(file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+            hash = fnv1a(buffer.data(), file.gcount(), hash);
+        return hash;
+    }
+
+    class Writer {
+    public:
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        void write(const T& value) {
+            auto bytes = reinterpret_cast<const char*>(&value);
+            this->data.insert(this->data.end(), bytes, bytes + sizeof(T));
+        }
+
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        void write(const std::vector<T>& values) {
+            this->write(uint32_t(values.size()));
+            auto bytes = reinterpret_cast<const char*>(values.data());
+            this->data.insert(this->data.end(), bytes, bytes + values.size() * sizeof(T));
+        }
+
+        void write(const std::string& str) {
+            this->write(uint32_t(str.size()));
+            this->data.insert(this->data.end(), str.begin(), str.end());
+        }
+
+        const std::vector<char>& getData() const { return this->data; }
+        std::vector<char>& getData() { return this->data; }
+
+        //Writes to a temporary file first so a crash never leaves a half written file behind
+        void save(const std::filesystem::path& path) const {
+            auto tmp = path;
+            tmp += ".tmp";
+            {
+                std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+                if(!file.is_open() || !file.write(this->data.data(), this->data.size()))
+                    throw std::runtime_error("failed to write file " + tmp.string());
+            }
+            std::filesystem::rename(tmp, path);
+        }
+
+    private:
+        std::vector<char> data;
+
+    };
+
+    class Reader {
+    public:
+        Reader(const char* data, size_t size): data{data}, size{size} {}
+
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        T read() {
+            T value;
+            std::memcpy(&value, this->take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        template<typename T> requires std::is_trivially_copyable_v<T>
+        std::vector<T> readVector() {
+            auto count = this->read<uint32_t>();
+            auto bytes = this->take(size_t(count) * sizeof(T)); //Before allocating, a corrupted count fails here
+            std::vector<T> values(count);
+            std::memcpy(values.data(), bytes, size_t(count) * sizeof(T));
+            return values;
+        }
+
+        std::string readString() {
+            auto length = this->read<uint32_t>();
+            return std::string(this->take(length), length);
+        }
+
+        const char* take(size_t bytes) {
+            if(bytes > this->size - this->offset)
+                throw std::runtime_error("unexpected end of binary data!");
+            auto ptr = this->data + this->offset;
+            this->offset += bytes;
+            return ptr;
+        }
+
+        size_t remaining() const { return this->size - this->offset; }
+
+    private:
+        const char* data;
+        size_t size, offset = 0;
+
+    };
+
+    inline std::vector<char> readFile(const std::filesystem::path& path) {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if(!file.is_open())
+            throw std::runtime_error("failed to open file " + path.string());
+
+        std::vector<char> buffer(file.tellg());
+        file.seekg(0);
+        file.read(buffer.data(), buffer.size());
+        return buffer;
+    }
+
+}
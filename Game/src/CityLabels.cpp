@@ -0,0 +1,116 @@
+#include "CityLabels.hpp"
+#include "EarthCamera.hpp"
+
+#include <Engine.hpp>
+#include <algorithm>
+
+//Code points of a UTF-8 string, as every glyph takes about the same width
+static size_t utf8Length(const std::string& text) {
+    return std::count_if(text.begin(), text.end(), [](char c){ return (static_cast<unsigned char>(c) & 0xC0) != 0x80; });
+}
+
+//LABEL PLACER IMPLEMENTATION
+void LabelPlacer::setCandidates(std::vector<LabelCandidate> candidates) {
+    std::stable_sort(candidates.begin(), candidates.end(), [](auto& a, auto& b){ return a.population > b.population; });
+    this->candidates = std::move(candidates);
+
+    this->widths.resize(this->candidates.size());
+    this->positions.resize(this->candidates.size());
+    for(size_t i=0; i<this->candidates.size(); ++i) {
+        this->widths[i] = utf8Length(this->candidates[i].text) * GLYPH_WIDTH;
+        this->positions[i] = this->candidates[i].pos;
+    }
+    this->screenPositions.resize(this->candidates.size());
+    this->visible.resize(this->candidates.size());
+
+    this->placed.clear();
+    this->wasPlaced.assign(this->candidates.size(), 0);
+    this->lastScreenSize = {0, 0};
+}
+
+const std::vector<PlacedLabel>& LabelPlacer::place(const ViewState& view, float fontSize) {
+    auto screenSize = view.screenSize;
+    if(view.viewProj == this->lastViewProj && screenSize == this->lastScreenSize && fontSize == this->lastFontSize)
+        return this->placed;
+    this->lastViewProj = view.viewProj;
+    this->lastScreenSize = screenSize;
+    this->lastFontSize = fontSize;
+
+    this->gridWidth = int(screenSize.x) / CELL_SIZE + 1;
+    this->gridHeight = int(screenSize.y) / CELL_SIZE + 1;
+    this->grid.assign(this->gridWidth * this->gridHeight, 0);
+
+    auto previous = std::move(this->wasPlaced);
+    this->wasPlaced.assign(this->candidates.size(), 0);
+    this->placed.clear();
+
+    view.project(this->positions, this->screenPositions, this->visible);
+
+    auto visit = [&](uint32_t i) {
+        if(!this->visible[i])
+            return;
+
+        auto screen = this->screenPositions[i];
+        if(this->tryPlace(screen, this->widths[i] * fontSize, fontSize)) {
+            this->placed.emplace_back(i, screen);
+            this->wasPlaced[i] = 1;
+        }
+    };
+
+    for(uint32_t i=0; i<this->candidates.size(); ++i) {
+        if(previous[i])
+            visit(i);
+    }
+    for(uint32_t i=0; i<this->candidates.size(); ++i) {
+        if(!previous[i])
+            visit(i);
+    }
+
+    return this->placed;
+}
+
+bool LabelPlacer::tryPlace(glm::vec2 anchor, float width, float height) {
+    auto x0 = anchor.x + ANCHOR_OFFSET, y0 = anchor.y - height/2;
+    auto x1 = x0 + width, y1 = y0 + height;
+    if(x0 < 0 || y0 < 0 || x1 >= this->lastScreenSize.x || y1 >= this->lastScreenSize.y)
+        return false;
+
+    int cx0 = int(x0) / CELL_SIZE, cx1 = int(x1) / CELL_SIZE;
+    int cy0 = int(y0) / CELL_SIZE, cy1 = int(y1) / CELL_SIZE;
+    for(int y=cy0; y<=cy1; ++y) {
+        for(int x=cx0; x<=cx1; ++x) {
+            if(this->grid[y * this->gridWidth + x])
+                return false;
+        }
+    }
+
+    for(int y=cy0; y<=cy1; ++y)
+        std::fill_n(this->grid.begin() + y * this->gridWidth + cx0, cx1 - cx0 + 1, 1);
+
+    return true;
+}
+
+
+//CITY LABELS IMPLEMENTATION
+void CityLabels::load(const std::vector<City>& cities) {
+    std::vector<LabelCandidate> candidates;
+    candidates.reserve(cities.size());
+    for(auto& c: cities)
+        candidates.emplace_back(c.name, EarthCamera::coordToPos(c.coord), c.population);
+
+    this->placer.setCandidates(std::move(candidates));
+}
+
+void CityLabels::render(fly::TextRenderer& textRenderer, const std::string& font, const ViewState& view) {
+    auto& placed = this->placer.place(view, FONT_SIZE);
+    auto& candidates = this->placer.getCandidates();
+
+    for(auto& label: placed) {
+        textRenderer.renderText(
+            font,
+            candidates[label.candidate].text,
+            {label.screenPos.x + LabelPlacer::ANCHOR_OFFSET, label.screenPos.y - FONT_SIZE/2},
+            fly::Align::LEFT, FONT_SIZE, {1, 1, 1, 1}
+        );
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "CitySpawner.hpp"
+#include "ViewState.hpp"
+
+#include <vector>
+#include <string>
+#include <glm/glm.hpp>
+
+namespace fly {
+    class TextRenderer;
+}
+
+struct LabelCandidate {
+    std::string text;
+    glm::vec3 pos; //On the unit sphere
+    int population;
+};
+
+struct PlacedLabel {
+    uint32_t candidate;
+    glm::vec2 screenPos; //Pixels from the top left corner
+};
+
+//Greedy label placement on a screen space occupancy grid, it doesn't touch the GPU
+class LabelPlacer {
+public:
+    static constexpr int CELL_SIZE = 8; //Pixels
+    static constexpr float GLYPH_WIDTH = 0.55f; //Of the font size
+    static constexpr float ANCHOR_OFFSET = 4.0f; //Pixels between the city and its label
+
+public:
+    LabelPlacer() = default;
+    ~LabelPlacer() = default;
+
+    void setCandidates(std::vector<LabelCandidate> candidates);
+    const std::vector<LabelCandidate>& getCandidates() const { return this->candidates; }
+
+    //Labels placed last frame are tried first so they don't flicker, the rest go by population
+    const std::vector<PlacedLabel>& place(const ViewState& view, float fontSize);
+
+private:
+    std::vector<LabelCandidate> candidates; //Sorted by population
+    std::vector<float> widths;
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec2> screenPositions;
+    std::vector<uint8_t> visible;
+
+    std::vector<PlacedLabel> placed;
+    std::vector<uint8_t> wasPlaced;
+    std::vector<uint8_t> grid;
+    int gridWidth = 0, gridHeight = 0;
+
+    glm::mat4 lastViewProj = glm::mat4(0.0f);
+    glm::vec2 lastScreenSize = {0, 0};
+    float lastFontSize = 0;
+
+private:
+    bool tryPlace(glm::vec2 anchor, float width, float height);
+
+};
+
+class CityLabels {
+public:
+    static constexpr float FONT_SIZE = 14.0f;
+
+public:
+    CityLabels() = default;
+    ~CityLabels() = default;
+
+    void load(const std::vector<City>& cities);
+    //One renderText call per placed label, TextRenderer can't draw several positioned strings in one call
+    void render(fly::TextRenderer& textRenderer, const std::string& font, const ViewState& view);
+
+private:
+    LabelPlacer placer;
+
+};
@@ -1,7 +1,9 @@
 #include "CitySpawner.hpp"
+#include "Telemetry.hpp"
 
 #include <nlohmann/json.hpp>
 #include <fstream>
+#include <algorithm>
 
 void CitySpawner::load() {
     using json = nlohmann::json;
@@ -19,6 +21,7 @@ void CitySpawner::load() {
             c.coord = {coord[0], coord[1]};
             c.capital = e["capital"].template get<bool>();
             c.country = k;
+            c.index = int(cities[k].size());
 
             cities[k].emplace_back(std::move(c));
         }
@@ -26,6 +29,7 @@ void CitySpawner::load() {
 }
 
 std::optional<City> CitySpawner::getRandomCity() {
+    Telemetry::add(Metric::SPAWNER_CALLS);
     std::optional<City> city;
 
     if(!pendingCities.empty()) {
@@ -64,11 +68,8 @@ std::vector<std::pair<std::string, int>> CitySpawner::getCityIndices(const std::
     std::vector<std::pair<std::string, int>> indices(cities.size());
 
     for(int i=0; i<int(cities.size()); ++i) {
-        auto cnt = cities[i].country;
         indices[i].first = cities[i].country;
-        const auto& cntCities = this->cities.at(cnt);
-        indices[i].second = std::find_if(cntCities.begin(), cntCities.end(), 
-            [&cities, i](auto c){ return c.name == cities[i].name; }) - cntCities.begin();
+        indices[i].second = cities[i].index;
     }
 
     return indices;
@@ -83,3 +84,66 @@ std::vector<City> CitySpawner::getCityVector(const std::vector<std::pair<std::st
 
     return cities;
 }
+
+CitySpawnerSave CitySpawner::save(const std::vector<std::string>& countryCodes) const {
+    auto countryIndex = [&countryCodes](const std::string& country) {
+        return uint16_t(std::lower_bound(countryCodes.begin(), countryCodes.end(), country) - countryCodes.begin());
+    };
+
+    CitySpawnerSave save;
+    save.generator = this->generator;
+
+    save.possibleCountries.reserve(this->possibleCountries.size());
+    for(auto& p: this->possibleCountries)
+        save.possibleCountries.emplace_back(CityRef{countryIndex(p.name), uint16_t(p.currentCity)}, p.population);
+
+    auto pending = this->pendingCities;
+    save.pendingCities.reserve(pending.size());
+    for(; !pending.empty(); pending.pop())
+        save.pendingCities.emplace_back(countryIndex(pending.front().country), uint16_t(pending.front().index));
+
+    return save;
+}
+
+bool CitySpawner::restore(const CitySpawnerSave& save, const std::vector<std::string>& countryCodes) {
+    //The next city of a country is one past its last city once every city has spawned
+    auto isValid = [&](CityRef ref, size_t extra) {
+        if(ref.country >= countryCodes.size())
+            return false;
+        auto it = this->cities.find(countryCodes[ref.country]);
+        return it != this->cities.end() && ref.city < it->second.size() + extra;
+    };
+    for(auto& p: save.possibleCountries) {
+        if(!isValid(p.next, 1))
+            return false;
+    }
+    for(auto& c: save.pendingCities) {
+        if(!isValid(c, 0))
+            return false;
+    }
+
+    this->generator = save.generator;
+
+    this->possibleCountries.clear();
+    for(auto& p: save.possibleCountries)
+        this->possibleCountries.emplace_back(countryCodes.at(p.next.country), p.next.city, p.population);
+
+    this->pendingCities = {};
+    for(auto& c: save.pendingCities)
+        this->pendingCities.push(this->cities.at(countryCodes.at(c.country)).at(c.city));
+
+    return true;
+}
+
+std::vector<City> CitySpawner::getCityList() const {
+    std::vector<std::string> countries;
+    for(auto& [k, v]: this->cities)
+        countries.push_back(k);
+    std::sort(countries.begin(), countries.end());
+
+    std::vector<City> list;
+    for(auto& country: countries)
+        list.insert(list.end(), this->cities.at(country).begin(), this->cities.at(country).end());
+
+    return list;
+}
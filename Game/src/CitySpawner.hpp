@@ -7,12 +7,16 @@
 #include <random>
 #include <queue>
 #include <optional>
+#include <unordered_map>
 
 enum class CountryState { LOCKED, UNLOCKED, BANNED, HOVERED };
 
 struct Country {
     std::string name;
     CountryState state;
+
+    //[begin, end) ranges of every sub-mesh in the country mesh vertex buffer
+    std::vector<std::pair<uint32_t, uint32_t>> vertexRanges;
 };
 
 struct City {
@@ -20,6 +24,7 @@ struct City {
     int population;
     bool capital;
     std::string country;
+    int index; //Position in its country city list
     
     glm::vec2 coord;
 };
@@ -30,8 +35,21 @@ struct UnlockableCityData {
     int population;
 };
 
+//Cities are saved by the index of their country in the save country table and their index in that country
+struct CityRef {
+    uint16_t country;
+    uint16_t city;
+};
+
+struct SavedUnlockableCity {
+    CityRef next;
+    int32_t population;
+};
+
 struct CitySpawnerSave {
-    std::vector<UnlockableCityData> possibleCountries;
+    std::vector<SavedUnlockableCity> possibleCountries;
+    std::vector<CityRef> pendingCities;
+    std::mt19937_64 generator;
 };
 
 class CitySpawner {
@@ -47,8 +65,16 @@ public:
     std::vector<std::pair<std::string, int>> getCityIndices(const std::vector<City>& cities) const;
     std::vector<City> getCityVector(const std::vector<std::pair<std::string, int>>& indices) const;
 
+    //Every city of every country, ordered by country code and then as they come in the airports file
+    std::vector<City> getCityList() const;
+
     void load();
 
+    //Country codes must be sorted and contain every country with cities
+    CitySpawnerSave save(const std::vector<std::string>& countryCodes) const;
+    //Returns false without changing anything if the save refers to cities that aren't loaded, like a save of another airports.json
+    bool restore(const CitySpawnerSave& save, const std::vector<std::string>& countryCodes);
+
     std::optional<City> getRandomCity();
     void addCountry(const std::string& country);
 
@@ -0,0 +1,168 @@
+#include "CountryGraph.hpp"
+#include "BinaryIO.hpp"
+
+#include <Utils.hpp>
+#include <algorithm>
+#include <iostream>
+#include <cmath>
+
+void CountryGraph::build(const std::unordered_map<std::string, Country>& countries, std::span<const glm::vec2> vertices, float tolerance) {
+    fly::ScopeTimer t("COUNTRY GRAPH BUILD");
+
+    this->countries.clear();
+    for(auto& [k, v]: countries)
+        this->countries.push_back(k);
+    std::sort(this->countries.begin(), this->countries.end());
+
+    //Spatial hash of the border vertices, cells are as big as the tolerance so close vertices are at most one row away.
+    //Longitude degrees shrink with cos(latitude), so towards the poles close vertices can be several columns away
+    auto cellsX = int64_t(std::ceil(360.0f / tolerance));
+    auto cellsY = int64_t(std::ceil(180.0f / tolerance));
+    auto cellKey = [cellsX](int64_t x, int64_t y) {
+        x = ((x % cellsX) + cellsX) % cellsX; //Wraps around the antimeridian
+        return (uint64_t(y) << 32) | uint64_t(x);
+    };
+
+    struct CellEntry {
+        uint64_t cell;
+        uint32_t country;
+        float lon, lat;
+        auto operator<=>(const CellEntry&) const = default;
+    };
+
+    std::vector<CellEntry> entries;
+    entries.reserve(vertices.size());
+    for(uint32_t c=0; c<this->countries.size(); ++c) {
+        for(auto [begin, end]: countries.at(this->countries[c]).vertexRanges) {
+            for(auto i=begin; i<end && i<vertices.size(); ++i) {
+                auto x = int64_t(std::floor((vertices[i].x + 180.0f) / tolerance));
+                auto y = std::clamp(int64_t(std::floor((vertices[i].y + 90.0f) / tolerance)), int64_t(0), cellsY - 1);
+                entries.push_back({cellKey(x, y), c, vertices[i].x, vertices[i].y});
+            }
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    auto closeEnough = [tolerance](const CellEntry& a, const CellEntry& b) {
+        auto dLon = std::abs(a.lon - b.lon);
+        dLon = std::min(dLon, 360.0f - dLon);
+        dLon *= std::cos(glm::radians((a.lat + b.lat) * 0.5f));
+        auto dLat = a.lat - b.lat;
+        return dLon * dLon + dLat * dLat <= tolerance * tolerance;
+    };
+
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    auto scanRow = [&](const CellEntry& e, int64_t y, int64_t x0, int64_t x1) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), CellEntry{cellKey(x0, y), 0, -INFINITY, -INFINITY});
+        for(auto last = cellKey(x1, y); it != entries.end() && it->cell <= last; ++it) {
+            if(it->country != e.country && closeEnough(e, *it)) {
+                pairs.emplace_back(e.country, it->country);
+                pairs.emplace_back(it->country, e.country);
+            }
+        }
+    };
+    for(auto& e: entries) {
+        auto x = int64_t(e.cell & 0xFFFFFFFF), y = int64_t(e.cell >> 32);
+        for(auto row = std::max(y - 1, int64_t(0)); row <= std::min(y + 1, cellsY - 1); ++row) {
+            //Columns to search from the latitude of the row edge closest to the pole
+            auto poleLat = std::min(std::max(std::abs(row * tolerance - 90.0f), std::abs((row + 1) * tolerance - 90.0f)), 90.0f);
+            auto cosLat = std::cos(glm::radians(poleLat));
+            auto reach = cosLat * cellsX > 1? int64_t(std::ceil(1 / cosLat)) : cellsX;
+            if(2 * reach + 1 >= cellsX) {
+                scanRow(e, row, 0, cellsX - 1);
+            } else if(x - reach < 0) {
+                scanRow(e, row, 0, x + reach);
+                scanRow(e, row, x - reach + cellsX, cellsX - 1);
+            } else if(x + reach >= cellsX) {
+                scanRow(e, row, x - reach, cellsX - 1);
+                scanRow(e, row, 0, x + reach - cellsX);
+            } else {
+                scanRow(e, row, x - reach, x + reach);
+            }
+        }
+    }
+    std::sort(pairs.begin(), pairs.end());
+    pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+    //Pairs are added both ways, so the list is symmetric
+    this->offsets.assign(this->countries.size() + 1, 0);
+    this->neighbours.resize(pairs.size());
+    for(size_t i=0; i<pairs.size(); ++i) {
+        this->offsets[pairs[i].first + 1]++;
+        this->neighbours[i] = pairs[i].second;
+    }
+    for(size_t i=1; i<this->offsets.size(); ++i)
+        this->offsets[i] += this->offsets[i - 1];
+}
+
+bool CountryGraph::load(const std::filesystem::path& path, uint64_t dataHash) {
+    if(!std::filesystem::exists(path))
+        return false;
+
+    try {
+        auto data = bin::readFile(path);
+        bin::Reader reader(data.data(), data.size());
+        if(reader.read<uint32_t>() != CACHE_MAGIC || reader.read<uint32_t>() != CACHE_VERSION || reader.read<uint64_t>() != dataHash)
+            return false;
+
+        //Every string takes at least its length, so a corrupted count fails before allocating
+        auto count = reader.read<uint32_t>();
+        if(count > reader.remaining() / sizeof(uint32_t))
+            return false;
+
+        std::vector<std::string> countries(count);
+        for(auto& c: countries)
+            c = reader.readString();
+        auto offsets = reader.readVector<uint32_t>();
+        auto neighbours = reader.readVector<uint32_t>();
+
+        if(offsets.size() != countries.size() + 1 || offsets.front() != 0 || offsets.back() != neighbours.size())
+            return false;
+        if(!std::is_sorted(offsets.begin(), offsets.end()) || !std::is_sorted(countries.begin(), countries.end()))
+            return false;
+        if(std::any_of(neighbours.begin(), neighbours.end(), [&](uint32_t n){ return n >= countries.size(); }))
+            return false;
+
+        this->countries = std::move(countries);
+        this->offsets = std::move(offsets);
+        this->neighbours = std::move(neighbours);
+    } catch(const std::exception& e) {
+        //Anything wrong with the cache just means it gets rebuilt
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void CountryGraph::save(const std::filesystem::path& path, uint64_t dataHash) const {
+    bin::Writer writer;
+    writer.write(CACHE_MAGIC);
+    writer.write(CACHE_VERSION);
+    writer.write(dataHash);
+
+    writer.write(uint32_t(this->countries.size()));
+    for(auto& c: this->countries)
+        writer.write(c);
+    writer.write(this->offsets);
+    writer.write(this->neighbours);
+
+    writer.save(path);
+}
+
+int CountryGraph::getIndex(const std::string& country) const {
+    auto it = std::lower_bound(this->countries.begin(), this->countries.end(), country);
+    if(it == this->countries.end() || *it != country)
+        return -1;
+    return int(it - this->countries.begin());
+}
+
+bool CountryGraph::areNeighbours(const std::string& a, const std::string& b) const {
+    auto i = this->getIndex(a), j = this->getIndex(b);
+    if(i < 0 || j < 0)
+        return false;
+
+    auto n = this->getNeighbours(i);
+    return std::binary_search(n.begin(), n.end(), uint32_t(j));
+}
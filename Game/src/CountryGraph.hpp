@@ -0,0 +1,47 @@
+#pragma once
+
+#include "CitySpawner.hpp"
+
+#include <span>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <filesystem>
+#include <unordered_map>
+
+//Country adjacency graph in CSR form, two countries are neighbours if any two of their border vertices are closer than
+//the tolerance, with longitude differences scaled by cos(latitude)
+class CountryGraph {
+public:
+    static constexpr float BORDER_TOLERANCE = 0.05f; //Degrees, around 5km at the equator
+    static constexpr uint32_t CACHE_MAGIC = 0x41594c46; //FLYA
+    static constexpr uint32_t CACHE_VERSION = 2;
+
+public:
+    CountryGraph() = default;
+    ~CountryGraph() = default;
+
+    //Vertices are the (longitude, latitude) of the whole country mesh, indexed by Country::vertexRanges
+    void build(const std::unordered_map<std::string, Country>& countries, std::span<const glm::vec2> vertices, float tolerance = BORDER_TOLERANCE);
+
+    //The hash identifies the source data, a cache built from other data is rejected
+    bool load(const std::filesystem::path& path, uint64_t dataHash);
+    void save(const std::filesystem::path& path, uint64_t dataHash) const;
+
+    bool empty() const { return this->countries.empty(); }
+    size_t size() const { return this->countries.size(); }
+
+    int getIndex(const std::string& country) const;
+    const std::string& getCountry(uint32_t index) const { return this->countries[index]; }
+
+    std::span<const uint32_t> getNeighbours(uint32_t index) const {
+        return {this->neighbours.data() + this->offsets[index], this->neighbours.data() + this->offsets[index + 1]};
+    }
+    bool areNeighbours(const std::string& a, const std::string& b) const;
+
+private:
+    std::vector<std::string> countries; //Sorted by code
+    std::vector<uint32_t> offsets; //countries.size() + 1
+    std::vector<uint32_t> neighbours;
+
+};
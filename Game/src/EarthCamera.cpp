@@ -39,9 +39,10 @@ void EarthCamera::update(fly::Window& window, float dt) {
     ImGui::SliderFloat("Scroll acc", &this->scrollAcc, 0, 100);
     ImGui::SliderFloat("Angular damping", &this->angularDamping, 0, 1);*/
 
+    //The view state is still the one computed at the end of the last update
     this->mouseControlled = false;
     if(window.isMouseBtnPressed(fly::MouseButton::LEFT)) {
-        auto p = intersectRayUnitSphere( mouseRay(window, window.getMousePos()));
+        auto p = intersectRayUnitSphere( mouseRay(window.getMousePos()));
         auto oldMouse = window.getMousePos() - window.getMouseDelta();
         if(window.mouseClicked(fly::MouseButton::LEFT)) { //If last state was not pressed
             this->incT = 0;
@@ -51,7 +52,7 @@ void EarthCamera::update(fly::Window& window, float dt) {
         this->incT += dt;
 
         if(glm::length(window.getMouseDelta()) > 0) {
-            auto q = intersectRayUnitSphere( mouseRay(window, oldMouse));
+            auto q = intersectRayUnitSphere( mouseRay(oldMouse));
             this->lastMouse = window.getMousePos();
 
             auto angle = glm::angle(p, q);
@@ -85,10 +86,11 @@ void EarthCamera::update(fly::Window& window, float dt) {
         this->mouseControlled = true;
         auto scrollSpeed = this->height * this->height * this->scrollAcc * window.getScroll();
 
-        auto p = intersectRayUnitSphere(mouseRay(window, window.getMousePos()));
+        auto p = intersectRayUnitSphere(mouseRay(window.getMousePos()));
         this->height = glm::clamp(this->height - scrollSpeed * dt, MIN_HEIGHT, MAX_HEIGHT);
         this->view = glm::lookAt(this->height * this->normPos, glm::vec3(0.0f), UP);
-        auto q = intersectRayUnitSphere(mouseRay(window, window.getMousePos()));
+        this->viewState = ViewState::create(this->proj, this->view, this->viewState.screenSize);
+        auto q = intersectRayUnitSphere(mouseRay(window.getMousePos()));
 
         auto angle = -glm::angle(p, q);
         if(!glm::isnan(angle) || angle != 0 || !glm::isinf(angle)) {
@@ -99,8 +101,8 @@ void EarthCamera::update(fly::Window& window, float dt) {
     
     if(glm::abs(this->angularVel) > 0 && !this->mouseControlled) {
         if(this->incT != 0) {
-            auto p = intersectRayUnitSphere(mouseRay(window, this->firstMouse));
-            auto q = intersectRayUnitSphere(mouseRay(window, this->lastMouse));
+            auto p = intersectRayUnitSphere(mouseRay(this->firstMouse));
+            auto q = intersectRayUnitSphere(mouseRay(this->lastMouse));
             this->angularVel = -glm::angle(p, q) / this->incT;
             this->rotAxis = glm::normalize(glm::cross(p, q));
             
@@ -120,44 +122,17 @@ void EarthCamera::update(fly::Window& window, float dt) {
 
     this->view = glm::lookAt(height * this->normPos, glm::vec3(0.0f), UP);
     if(window.getHeight() != 0)  {
-        this->proj = glm::perspective(glm::radians(this->fov), window.getWidth() / (float) window.getHeight(), 0.05f, 10.0f);
+        this->proj = glm::perspective(glm::radians(this->fov), window.getWidth() / (float) window.getHeight(), NEAR_PLANE, FAR_PLANE);
         this->proj[1][1] *= -1;
     }
-
+    this->viewState = ViewState::create(this->proj, this->view, glm::vec2(window.getWidth(), window.getHeight()));
 }
 
-Ray EarthCamera::mouseRay(fly::Window& window, glm::vec2 mousePos) const {    
-    float xNdc = (float(mousePos.x)/window.getWidth()  - 0.5f) * 2.0f;
-    float yNdc = (float(mousePos.y)/window.getHeight() - 0.5f) * 2.0f;
-
-    glm::mat4 invVP = glm::inverse(this->proj * this->view);
-
-    glm::vec4 rayStart = invVP * glm::vec4(xNdc, yNdc,-1.0f,1.0f); 
-    rayStart /= rayStart.w;
-    glm::vec4 rayEnd = invVP * glm::vec4(xNdc, yNdc,0.0f,1.0f);
-    rayEnd /= rayEnd.w;
-    
-    glm::vec3 rayDir = glm::normalize(glm::vec3(rayEnd - rayStart));
-    
-    return Ray {rayStart,rayDir };
+Ray EarthCamera::mouseRay(glm::vec2 mousePos) const {
+    return this->viewState.mouseRay(mousePos);
 }
 
-glm::vec3 EarthCamera::intersectRayUnitSphere(Ray r) {
-    float b = glm::dot(r.origin, r.direction); 
-    float c = glm::dot(r.origin, r.origin) - 1; 
-
-    if (c > 0.0f && b > 0.0f) 
-        return glm::vec3(0, 0, 0); 
-    float discr = b*b - c; 
-
-    if (discr < 0.0f) 
-        return glm::vec3(0, 0, 0);
-
-    float t = -b - glm::sqrt(discr); 
-
-    if (t < 0.0f) t = 0.0f; 
-    glm::vec3 q = r.origin + t * r.direction; 
-
-    return q;
+glm::vec3 EarthCamera::coordToPos(glm::vec2 coord) {
+    auto lon = glm::radians(coord.x), lat = glm::radians(coord.y);
+    return glm::vec3(glm::cos(lat) * glm::sin(lon), glm::sin(lat), glm::cos(lat) * glm::cos(lon));
 }
-
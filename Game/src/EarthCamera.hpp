@@ -2,18 +2,17 @@
 
 #include <glm/glm.hpp>
 
+#include "ViewState.hpp"
+
 namespace fly {
     class Window;
 }
 
-struct Ray {
-    glm::vec3 origin, direction;
-};
-
 class EarthCamera {
 public:
     static constexpr glm::vec3 UP = {0, 1, 0};
     static constexpr float MAX_LAT = 65.0f, MIN_HEIGHT = 1.15f, MAX_HEIGHT = 5.0f;
+    static constexpr float NEAR_PLANE = 0.05f, FAR_PLANE = 10.0f;
 
 public:
     EarthCamera() = default;
@@ -25,12 +24,16 @@ public:
     glm::mat4 getView() const { return this->view; } 
 
     glm::vec3 getPos() const { return this->normPos * height; }
+    const ViewState& getViewState() const { return this->viewState; }
+
+    Ray mouseRay(glm::vec2 mousePos) const;
 
-    Ray mouseRay(fly::Window& window, glm::vec2 mousePos) const;
-    static glm::vec3 intersectRayUnitSphere(Ray ray);
+    //From (longitude, latitude) in degrees to the unit sphere, the same convention as the LAT/LON shown in update
+    static glm::vec3 coordToPos(glm::vec2 coord);
 
 private:
-    glm::mat4 proj, view;
+    glm::mat4 proj = glm::mat4(1.0f), view = glm::mat4(1.0f);
+    ViewState viewState;
     glm::vec3 normPos = {0, 0, 1};
     float height = 1.5f;
 
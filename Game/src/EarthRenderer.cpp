@@ -1,11 +1,14 @@
 #include "EarthRenderer.hpp"
+#include "MeshOptimizer.hpp"
 
 #include <Utils.hpp>
 #include <filesystem>
+#include <iostream>
+#include <format>
 
 
 //EARTH RENDERER IMPLEMENTATION
-EarthRenderer::EarthRenderer(fly::Engine& engine, unsigned divs) {
+EarthRenderer::EarthRenderer(fly::Engine& engine, unsigned divs, AsyncJobQueue& jobs): jobs{jobs} {
 	this->pipeline = engine.addPipeline<EarthPipepine>(0);
 
     this->earthCubemap = std::make_unique<fly::Texture>(engine.getVulkanInstance(), engine.getCommandPool(), std::filesystem::path(EARTH_CUBEMAP_SRC));
@@ -13,17 +16,33 @@ EarthRenderer::EarthRenderer(fly::Engine& engine, unsigned divs) {
 
     this->uniformBuffer = std::make_unique<fly::TUniformBuffer<UBOEarth>>(engine.getVulkanInstance());
 
-	this->divs = divs;
-    this->meshIdx = this->pipeline->attachModel(EarthRenderer::generateCubesphere(engine.getVulkanInstance(), engine.getCommandPool(), divs));
-	this->pipeline->updateDescriptorSet(this->meshIdx, *this->uniformBuffer, *this->earthCubemap, *this->earthCubemapSampler);
+	this->divs = this->requestedDivs = divs;
+    this->attachCubesphere(engine, EarthRenderer::generateCubesphere(divs));
 }
 
 void EarthRenderer::render(fly::Engine& engine, uint32_t currentFrame, unsigned divs, glm::mat4 projection, glm::mat4 view) {
-	if(this->divs != divs) {
-		this->divs = divs;
-        this->pipeline->detachModel(this->meshIdx, currentFrame);
-   		this->meshIdx = this->pipeline->attachModel(EarthRenderer::generateCubesphere(engine.getVulkanInstance(), engine.getCommandPool(), divs));
-		this->pipeline->updateDescriptorSet(this->meshIdx, *this->uniformBuffer, *this->earthCubemap, *this->earthCubemapSampler);
+	if(this->requestedDivs != divs) {
+		this->requestedDivs = divs;
+
+		//Requests superseded by a newer one are skipped on both sides
+		auto data = std::make_shared<CubesphereData>();
+		this->jobs.submit(
+			[this, data, divs]() -> size_t {
+				if(this->requestedDivs != divs)
+					return 0;
+				*data = EarthRenderer::generateCubesphere(divs);
+				return data->vertices.size() * sizeof(fly::SimpleVertex) + data->indices.size() * sizeof(uint32_t);
+			},
+			[this, data, divs, &engine](uint32_t frame) -> size_t {
+				if(this->requestedDivs != divs || data->indices.empty())
+					return 0;
+				size_t bytes = data->vertices.size() * sizeof(fly::SimpleVertex) + data->indices.size() * sizeof(uint32_t);
+				this->pipeline->detachModel(this->meshIdx, frame);
+				this->attachCubesphere(engine, std::move(*data));
+				this->divs = divs;
+				return bytes;
+			}
+		);
 	}
 
 	UBOEarth ubo;
@@ -33,6 +52,14 @@ void EarthRenderer::render(fly::Engine& engine, uint32_t currentFrame, unsigned
 }
 
 
+void EarthRenderer::attachCubesphere(fly::Engine& engine, CubesphereData data) {
+	this->meshIdx = this->pipeline->attachModel(std::make_unique<fly::SimpleVertexArray>(
+		engine.getVulkanInstance(), engine.getCommandPool(), std::move(data.vertices), std::move(data.indices)
+	));
+	this->pipeline->updateDescriptorSet(this->meshIdx, *this->uniformBuffer, *this->earthCubemap, *this->earthCubemapSampler);
+}
+
+
 //EARTH PIPEPELINE IMPLEMENTATION
 void EarthPipepine::updateDescriptorSet(
     unsigned meshIndex,
@@ -190,7 +217,7 @@ int createBottomFace(size_t len, std::vector<uint32_t>& triangles, int divs, int
 	return t;
 }
 
-std::unique_ptr<fly::SimpleVertexArray> EarthRenderer::generateCubesphere(const fly::VulkanInstance& vk, const VkCommandPool commandPool, int divs) {
+CubesphereData EarthRenderer::generateCubesphere(int divs, bool optimize) {
     int cornerVertices = 8;
 	int edgeVertices = (divs + divs + divs - 3) * 4;
 	int faceVertices = (
@@ -244,5 +271,21 @@ std::unique_ptr<fly::SimpleVertexArray> EarthRenderer::generateCubesphere(const
 	    vtx.pos.z = v.z * glm::sqrt(1 - x2 / 2 - y2 / 2 + x2 * y2 / 3);
     }
 
-    return std::make_unique<fly::SimpleVertexArray>(vk, commandPool, std::move(vertices), std::move(indices));
+    if(optimize) {
+        mesh::optimizeVertexCache(indices, vertices.size());
+        mesh::optimizeVertexFetch(vertices, indices);
+    }
+
+    return {std::move(vertices), std::move(indices)};
+}
+
+void EarthRenderer::analyzeCubesphere(int divs) {
+    auto data = EarthRenderer::generateCubesphere(divs, false);
+    auto before = mesh::analyzeVertexCache(data.indices, data.vertices.size());
+    mesh::optimizeVertexCache(data.indices, data.vertices.size());
+    mesh::optimizeVertexFetch(data.vertices, data.indices);
+    auto after = mesh::analyzeVertexCache(data.indices, data.vertices.size());
+
+    std::cout << std::format("Cubesphere {} ({} entry cache): ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}", 
+        divs, mesh::CACHE_SIZE, before.acmr, after.acmr, before.atvr, after.atvr) << std::endl;
 }
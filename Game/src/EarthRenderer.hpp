@@ -1,7 +1,10 @@
 #pragma once
 
+#include "AsyncJobQueue.hpp"
+
 #include <Engine.hpp>
 #include <renderer/Skybox.hpp>
+#include <atomic>
 
 static const char* const EARTH_FRAG_SHADER_SRC = "Game/shaders/earthfrag.spv";
 static const char* const EARTH_VERT_SHADER_SRC = "Game/shaders/earthvert.spv";
@@ -17,6 +20,11 @@ const std::array<const char*, 6> earthCubemapPaths = {
     "assets/skybox/earth/nz.ktx2",
 };
 
+struct CubesphereData {
+    std::vector<fly::SimpleVertex> vertices;
+    std::vector<uint32_t> indices;
+};
+
 struct UBOEarth {
     glm::mat4 projection;
 	glm::mat4 view;
@@ -26,22 +34,32 @@ class EarthPipepine;
 
 class EarthRenderer {
 public:
-    EarthRenderer(fly::Engine& engine, unsigned divs);
+    EarthRenderer(fly::Engine& engine, unsigned divs, AsyncJobQueue& jobs);
     ~EarthRenderer() = default;
 
     void render(fly::Engine& engine, uint32_t currentFrame, unsigned divs, glm::mat4 projection, glm::mat4 view);
 
+    uint32_t getTriangleCount() const { return 12 * this->divs * this->divs; }
+
+    //Prints the vertex cache stats of the cubesphere before and after the optimization, it only uses the CPU
+    static void analyzeCubesphere(int divs);
+
 private:
     EarthPipepine* pipeline = nullptr;
 
     unsigned meshIdx, divs;
 
+    //The mesh is rebuilt in the job queue, the old one is drawn until the last requested one is ready
+    AsyncJobQueue& jobs;
+    std::atomic<unsigned> requestedDivs;
+
     std::unique_ptr<fly::TUniformBuffer<UBOEarth>> uniformBuffer;
     std::unique_ptr<fly::TextureSampler> earthCubemapSampler;
     std::unique_ptr<fly::Texture> earthCubemap;
 
 private:
-    static std::unique_ptr<fly::SimpleVertexArray> generateCubesphere(const fly::VulkanInstance& vk, const VkCommandPool commandPool, int divs);
+    static CubesphereData generateCubesphere(int divs, bool optimize = true);
+    void attachCubesphere(fly::Engine& engine, CubesphereData data);
 
 };
 
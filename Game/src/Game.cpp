@@ -1,8 +1,12 @@
 #include "Game.hpp"
 #include "CitySpawner.hpp"
+#include "BinaryIO.hpp"
 
 #include <memory>
 #include <random>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 
 #include <imgui.h>
 #include <GLFW/glfw3.h>
@@ -10,11 +14,15 @@
 
 static const char* const SKYBOX_SRC = "assets/skybox/skybox.ktx2";
 static const char* const PLANE_MODEL_PATH = "assets/plane.obj";
+static const char* const VIKING_MODEL_PATH = "assets/viking_room.obj";
 
 static const char* const PLANE_TEXTURE_PATH = "assets/plane.jpg";
 
 
 void Game::init(fly::Engine& engine) {
+    if(auto telemetryPath = std::getenv("FLY_TELEMETRY"))
+        Telemetry::start(telemetryPath);
+
     std::mt19937_64 rng(std::random_device{}());
     std::normal_distribution norm(78.0, 5.0);
     for(int i=0; i<50; ++i) {
@@ -41,11 +49,9 @@ void Game::init(fly::Engine& engine) {
     this->skybox = std::make_unique<fly::Skybox>(engine, std::move(cubemap), std::move(cubemapSampler));
     this->uniformBuffer = std::make_unique<fly::TUniformBuffer<fly::DefaultUBO>>(engine.getVulkanInstance());
     
-    auto planeVAO = loadModel(engine.getVulkanInstance(), engine.getCommandPool(), std::filesystem::path(PLANE_MODEL_PATH));
-    this->vertices = planeVAO->getVertices();
-    this->indices = planeVAO->getIndices();
+    this->planeMesh = this->meshes.get(engine.getVulkanInstance(), engine.getCommandPool(), std::filesystem::path(PLANE_MODEL_PATH));
 
-    this->earth = std::make_unique<EarthRenderer>(engine, 100);
+    this->earth = std::make_unique<EarthRenderer>(engine, 100, this->asyncJobs);
 
     this->loadMap();
 }
@@ -61,22 +67,42 @@ void Game::run(double dt, uint32_t currentFrame, fly::Engine& engine) {
         ImGui::SliderInt("Divs", &sphereDivs, 2, 1000);
     }
 
+    this->asyncJobs.flush(currentFrame);
     this->cam.update(engine.getWindow(), dt);
     if(window.keyJustPressed(GLFW_KEY_F)) {
-        auto vertices = this->vertices;
-        auto indices = this->indices;
-        this->planeIdx = defaultPipeline->attachModel(
-            std::make_unique<fly::VertexArray>(vk, engine.getCommandPool(), std::move(vertices), std::move(indices))
-        );
-        this->defaultPipeline->updateDescriptorSet(
-            planeIdx, 
-            *uniformBuffer, 
-            *planeTexture, 
-            *planeSampler
+        //The mesh is copied on the worker and uploaded in a later flush, releasing F before that skips the upload
+        auto request = ++this->planeRequest;
+        auto mesh = this->planeMesh;
+        auto data = std::make_shared<std::pair<std::vector<fly::Vertex>, std::vector<uint32_t>>>();
+        this->asyncJobs.submit(
+            [mesh, data]() -> size_t {
+                data->first.assign(mesh->vertices.begin(), mesh->vertices.end());
+                data->second.assign(mesh->indices.begin(), mesh->indices.end());
+                return mesh->vertices.size_bytes() + mesh->indices.size_bytes();
+            },
+            [this, &engine, request, data](uint32_t) -> size_t {
+                if(this->planeRequest != request)
+                    return 0;
+                size_t bytes = data->first.size() * sizeof(fly::Vertex) + data->second.size() * sizeof(uint32_t);
+                this->planeIdx = this->defaultPipeline->attachModel(std::make_unique<fly::VertexArray>(
+                    engine.getVulkanInstance(), engine.getCommandPool(), std::move(data->first), std::move(data->second)
+                ));
+                this->defaultPipeline->updateDescriptorSet(
+                    planeIdx, 
+                    *uniformBuffer, 
+                    *planeTexture, 
+                    *planeSampler
+                );
+                this->planeAttached = true;
+                return bytes;
+            }
         );
     }
     if(window.keyJustReleased(GLFW_KEY_F)) {
-        this->defaultPipeline->detachModel(this->planeIdx, currentFrame);
+        ++this->planeRequest;
+        if(this->planeAttached)
+            this->defaultPipeline->detachModel(this->planeIdx, currentFrame);
+        this->planeAttached = false;
     }
     if(window.isKeyPressed(GLFW_KEY_G)) {
         fly::ScopeTimer t("TEXT CPU RENDERING");
@@ -86,7 +112,13 @@ void Game::run(double dt, uint32_t currentFrame, fly::Engine& engine) {
             {0, 0}, fly::Align::LEFT, 14.0, {1, 1, 1, 1}
         );
     }
+    if(window.keyJustPressed(GLFW_KEY_L))
+        this->showLabels = !this->showLabels;
+    if(this->showLabels) {
+        this->labels.render(engine.getTextRenderer(), "DS_DIGITAL", cam.getViewState());
+    }
     totalTime += dt;
+    Telemetry::set(Metric::FRAME_TIME, dt * 1000.0);
     fly::DefaultUBO ubo, skyboxUbo;
     ubo.model = glm::mat4(1.0f);
     ubo.view = this->cam.getView();
@@ -104,27 +136,66 @@ void Game::run(double dt, uint32_t currentFrame, fly::Engine& engine) {
 
     this->earth->render(engine, currentFrame, sphereDivs, cam.getProjection(), cam.getView());
 
+    this->frameStats = {};
+    this->frameStats.addPipeline(1, 0); //Skybox, its cube is internal to the engine
+    this->frameStats.addPipeline(1, this->earth->getTriangleCount());
+    if(this->planeAttached)
+        this->frameStats.addPipeline(1, this->planeMesh->indices.size() / 3);
+    ImGui::Text("Draws: %u Pipelines: %u Triangles: %llu", 
+        this->frameStats.draws, this->frameStats.pipelineBinds, (unsigned long long) this->frameStats.triangles);
+    Telemetry::set(Metric::DRAWS, this->frameStats.draws);
+    Telemetry::set(Metric::TRIANGLES, this->frameStats.triangles);
+
 
     if(window.keyJustPressed(GLFW_KEY_C)) {
-        auto isoIt = this->countries.begin();
-        std::advance( isoIt, rand() % this->countries.size() );
+        auto iso = this->pickCountryToUnlock();
 
-        if(this->countries[isoIt->first].state == CountryState::LOCKED) {
-            spawner.addCountry(isoIt->first);
-            this->countries[isoIt->first].state = CountryState::UNLOCKED;
-            std::cout << isoIt->second.name << std::endl;
+        if(this->countries[iso].state == CountryState::LOCKED) {
+            spawner.addCountry(iso);
+            this->countries[iso].state = CountryState::UNLOCKED;
+            Telemetry::add(Metric::UNLOCKED_COUNTRIES);
+            std::cout << this->countries[iso].name << std::endl;
         }
     }
 
     if(window.keyJustPressed(GLFW_KEY_V)) {
         std::optional<City> city;
         while(city = spawner.getRandomCity(), !city.has_value());
+        Telemetry::add(Metric::CITIES_SPAWNED);
         std::cout << std::format("{} -> {}", city->name, countries[city->country].name) << std::endl;
     }
+
+    if(window.keyJustPressed(GLFW_KEY_F5) || totalTime - lastSaveTime > AUTOSAVE_PERIOD) {
+        if(saves.saveAsync(this->captureSnapshot()))
+            this->lastSaveTime = totalTime;
+    }
+    if(window.keyJustPressed(GLFW_KEY_F9)) {
+        if(auto snapshot = saves.load())
+            this->restoreSnapshot(*snapshot);
+    }
+
+    if(window.keyJustPressed(GLFW_KEY_M)) {
+        this->meshes.benchmark(vk, engine.getCommandPool(), std::filesystem::path(PLANE_MODEL_PATH));
+        this->meshes.benchmark(vk, engine.getCommandPool(), std::filesystem::path(VIKING_MODEL_PATH));
+    }
+
+    bool benchmarkRunning = this->benchmarkTask.valid() && this->benchmarkTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    if(window.keyJustPressed(GLFW_KEY_B) && !benchmarkRunning) {
+        this->benchmarkTask = std::async(std::launch::async, [this]() {
+            auto qps = this->planner.benchmark(10000);
+            std::cout << std::format("Route planner: {:.0f} queries/s", qps) << std::endl;
+        });
+    }
+    if(window.keyJustPressed(GLFW_KEY_O) && !benchmarkRunning)
+        this->benchmarkTask = std::async(std::launch::async, EarthRenderer::analyzeCubesphere, sphereDivs);
+
+    Telemetry::sample(totalTime);
 }
 
 void Game::loadMap() {
     spawner.load();
+    planner.load(spawner.getCityList());
+    labels.load(planner.getCities());
 
     //COUNTRY MESH
     using json = nlohmann::json;
@@ -136,7 +207,94 @@ void Game::loadMap() {
         c.name = v["name"].template get<std::string>();
         auto banned = v["banned"].template get<bool>();
         c.state = banned? CountryState::BANNED : CountryState::LOCKED;
+        for(auto& m: v["mesh"])
+            c.vertexRanges.emplace_back(m["vertexIndex"][0].template get<uint32_t>(), m["vertexIndex"][1].template get<uint32_t>());
 
         this->countries[k] = std::move(c);
     }
+
+    auto codes = std::make_shared<std::vector<std::string>>();
+    for(auto& [k, v]: this->countries)
+        codes->push_back(k);
+    std::sort(codes->begin(), codes->end());
+    this->countryCodes = std::move(codes);
+
+    this->loadCountryGraph();
+}
+
+void Game::loadCountryGraph() {
+    auto dataHash = bin::hashFile(COUNTRIES_DATA_FILE);
+    if(std::filesystem::exists(COUNTRY_VERTICES_FILE)) {
+        auto verticesHash = bin::hashFile(COUNTRY_VERTICES_FILE);
+        dataHash = bin::fnv1a(&verticesHash, sizeof(verticesHash), dataHash);
+    }
+    if(this->countryGraph.load(COUNTRY_GRAPH_FILE, dataHash))
+        return;
+
+    if(!std::filesystem::exists(COUNTRY_VERTICES_FILE)) {
+        std::cout << "Country graph not cached and no country vertices, countries will be unlocked at random" << std::endl;
+        return;
+    }
+
+    auto data = bin::readFile(COUNTRY_VERTICES_FILE);
+    std::vector<glm::vec2> vertices(data.size() / sizeof(glm::vec2));
+    std::memcpy(vertices.data(), data.data(), vertices.size() * sizeof(glm::vec2));
+
+    this->countryGraph.build(this->countries, vertices);
+    this->countryGraph.save(COUNTRY_GRAPH_FILE, dataHash);
+}
+
+std::string Game::pickCountryToUnlock() const {
+    //Countries grow from the unlocked ones to their neighbours, the first one or an isolated map are picked at random
+    std::vector<std::string> frontier;
+    for(auto& [iso, country]: this->countries) {
+        auto idx = this->countryGraph.getIndex(iso);
+        if(country.state != CountryState::UNLOCKED || idx < 0)
+            continue;
+
+        for(auto n: this->countryGraph.getNeighbours(idx)) {
+            auto& neighbour = this->countryGraph.getCountry(n);
+            auto it = this->countries.find(neighbour);
+            if(it != this->countries.end() && it->second.state == CountryState::LOCKED)
+                frontier.push_back(neighbour);
+        }
+    }
+
+    if(!frontier.empty())
+        return frontier[rand() % frontier.size()];
+
+    auto isoIt = this->countries.begin();
+    std::advance( isoIt, rand() % this->countries.size() );
+    return isoIt->first;
+}
+
+GameSnapshot Game::captureSnapshot() const {
+    GameSnapshot snapshot;
+    snapshot.countryCodes = this->countryCodes;
+    snapshot.countryStates.reserve(this->countryCodes->size());
+    for(auto& c: *this->countryCodes)
+        snapshot.countryStates.push_back(this->countries.at(c).state);
+
+    snapshot.spawner = this->spawner.save(*this->countryCodes);
+    snapshot.totalTime = this->totalTime;
+
+    return snapshot;
+}
+
+void Game::restoreSnapshot(const GameSnapshot& snapshot) {
+    if(!this->spawner.restore(snapshot.spawner, *snapshot.countryCodes)) {
+        std::cerr << "Load failed: the save doesn't match the loaded cities" << std::endl;
+        return;
+    }
+
+    //Countries are matched by code, so saves survive changes in countries.json
+    for(size_t i=0; i<snapshot.countryCodes->size(); ++i) {
+        auto it = this->countries.find((*snapshot.countryCodes)[i]);
+        if(it != this->countries.end())
+            it->second.state = snapshot.countryStates[i];
+    }
+
+    auto unlocked = std::count_if(this->countries.begin(), this->countries.end(), [](auto& c){ return c.second.state == CountryState::UNLOCKED; });
+    Telemetry::set(Metric::UNLOCKED_COUNTRIES, unlocked);
+    this->totalTime = this->lastSaveTime = snapshot.totalTime;
 }
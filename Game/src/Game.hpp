@@ -3,15 +3,43 @@
 #include "EarthRenderer.hpp"
 #include "EarthCamera.hpp"
 #include "CitySpawner.hpp"
+#include "RoutePlanner.hpp"
+#include "CountryGraph.hpp"
+#include "SaveManager.hpp"
+#include "CityLabels.hpp"
+#include "MeshRegistry.hpp"
+#include "Telemetry.hpp"
 
 #include <Engine.hpp>
 #include <renderer/DefaultPipeline.hpp>
 #include <renderer/Skybox.hpp>
 #include <unordered_map>
+#include <future>
 
 inline static const std::filesystem::path COUNTRIES_DATA_FILE = "resources/countries.json";
+inline static const std::filesystem::path COUNTRY_GRAPH_FILE = "resources/countries.adj";
+//Raw (longitude, latitude) float pairs of the country mesh, indexed by the vertexIndex ranges of countries.json
+inline static const std::filesystem::path COUNTRY_VERTICES_FILE = "resources/countries.vtx";
+inline static const std::filesystem::path SAVE_FILE = "save.bin";
+
+//What the game submits in a frame, the engine's own text and ImGui draws aren't visible from here
+struct FrameStats {
+    uint32_t draws = 0;
+    uint32_t pipelineBinds = 0;
+    uint64_t triangles = 0; //Of the meshes the game owns
+
+    //Each pipeline is bound once and draws its attached models
+    void addPipeline(uint32_t drawCount, uint64_t triangleCount) {
+        this->pipelineBinds++;
+        this->draws += drawCount;
+        this->triangles += triangleCount;
+    }
+};
 
 class Game: public fly::Scene {
+public:
+    static constexpr double AUTOSAVE_PERIOD = 60.0; //Seconds
+
 public:
     Game() = default;
     ~Game() = default;
@@ -26,9 +54,11 @@ private:
     fly::DefaultPipeline* defaultPipeline = nullptr;
 
     unsigned planeIdx;
+    bool planeAttached = false;
+    unsigned planeRequest = 0; //Every F press and release bumps it, a spawn job only attaches if it's still the latest
 
-    std::vector<fly::Vertex> vertices;
-    std::vector<uint32_t> indices;
+    MeshRegistry meshes;
+    std::shared_ptr<const MeshData> planeMesh;
 
     std::unique_ptr<fly::TextureSampler> planeSampler;
     std::unique_ptr<fly::Texture> planeTexture;
@@ -37,9 +67,21 @@ private:
     std::unique_ptr<fly::Skybox> skybox;
 
     std::unique_ptr<EarthRenderer> earth;
+    FrameStats frameStats;
+    AsyncJobQueue asyncJobs; //After the renderers so its worker stops before they're destroyed
 
     CitySpawner spawner;
+    RoutePlanner planner;
+    std::future<void> benchmarkTask; //Benchmarks run off the main thread one at a time, after the planner as they read it
     std::unordered_map<std::string, Country> countries;
+    CountryGraph countryGraph;
+    std::shared_ptr<const std::vector<std::string>> countryCodes;
+
+    CityLabels labels;
+    bool showLabels = false;
+
+    SaveManager saves{SAVE_FILE};
+    double lastSaveTime = 0;
 
     float gamma = 1.0f;
     glm::vec4 myColor;
@@ -47,4 +89,12 @@ private:
     std::string str;
     EarthCamera cam;
 
+private:
+    //Builds the graph from the country mesh vertices if it isn't cached, it's cached until countries.json or the vertices change
+    void loadCountryGraph();
+    std::string pickCountryToUnlock() const;
+
+    GameSnapshot captureSnapshot() const;
+    void restoreSnapshot(const GameSnapshot& snapshot);
+
 };
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    this->fileHandle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(this->fileHandle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("failed to open file " + path.string());
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(this->fileHandle, &size);
+    this->length = size.QuadPart;
+    if(this->length == 0)
+        return;
+
+    this->mappingHandle = CreateFileMappingW(this->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(this->mappingHandle)
+        this->ptr = static_cast<const char*>(MapViewOfFile(this->mappingHandle, FILE_MAP_READ, 0, 0, 0));
+
+    if(!this->ptr) {
+        if(this->mappingHandle)
+            CloseHandle(this->mappingHandle);
+        CloseHandle(this->fileHandle);
+        throw std::runtime_error("failed to map file " + path.string());
+    }
+}
+
+MappedFile::~MappedFile() {
+    if(this->ptr)
+        UnmapViewOfFile(this->ptr);
+    if(this->mappingHandle)
+        CloseHandle(this->mappingHandle);
+    if(this->fileHandle && this->fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(this->fileHandle);
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("failed to open file " + path.string());
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("failed to stat file " + path.string());
+    }
+
+    this->length = st.st_size;
+    if(this->length > 0) {
+        auto mapped = mmap(nullptr, this->length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapped == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("failed to map file " + path.string());
+        }
+        this->ptr = static_cast<const char*>(mapped);
+    }
+
+    //The mapping keeps the file alive
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if(this->ptr)
+        munmap(const_cast<char*>(this->ptr), this->length);
+}
+
+#endif
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+#include <cstddef>
+
+//Read only memory mapped file, the pages are shared with the OS file cache
+class MappedFile {
+public:
+    MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return this->ptr; }
+    size_t size() const { return this->length; }
+
+private:
+    const char* ptr = nullptr;
+    size_t length = 0;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+};
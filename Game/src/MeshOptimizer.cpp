@@ -0,0 +1,140 @@
+#include "MeshOptimizer.hpp"
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+mesh::VertexCacheStats mesh::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize) {
+    //A vertex is in the FIFO if less than cacheSize misses have happened since it was loaded
+    static constexpr uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+    std::vector<uint64_t> loadedAt(vertexCount, NEVER);
+    uint64_t misses = 0, referenced = 0;
+
+    for(auto i: indices) {
+        if(loadedAt[i] == NEVER)
+            referenced++;
+        if(loadedAt[i] == NEVER || misses - loadedAt[i] >= uint64_t(cacheSize)) {
+            loadedAt[i] = misses;
+            misses++;
+        }
+    }
+
+    VertexCacheStats stats;
+    stats.acmr = indices.empty()? 0 : float(misses) / (indices.size() / 3);
+    stats.atvr = referenced == 0? 0 : float(misses) / referenced;
+    return stats;
+}
+
+static float vertexScore(int cachePos, uint32_t liveTriangles) {
+    static constexpr float CACHE_DECAY = 1.5f, LAST_TRIANGLE_SCORE = 0.75f;
+    static constexpr float VALENCE_SCALE = 2.0f, VALENCE_POWER = 0.5f;
+
+    if(liveTriangles == 0)
+        return -1.0f;
+
+    float score = 0;
+    if(cachePos >= 0) {
+        //The vertices of the last triangle get a fixed score so it's not reused right away
+        if(cachePos < 3)
+            score = LAST_TRIANGLE_SCORE;
+        else
+            score = std::pow(1.0f - float(cachePos - 3) / (mesh::CACHE_SIZE - 3), CACHE_DECAY);
+    }
+
+    //Vertices with few triangles left are prioritized so they don't stay behind
+    return score + VALENCE_SCALE * std::pow(float(liveTriangles), -VALENCE_POWER);
+}
+
+void mesh::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+    auto triangleCount = indices.size() / 3;
+    if(triangleCount == 0)
+        return;
+
+    //Triangles of every vertex, the live ones are kept at the front of each list
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for(size_t i=0; i<triangleCount*3; ++i)
+        offsets[indices[i] + 1]++;
+    for(size_t v=0; v<vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> live(vertexCount, 0);
+    for(size_t i=0; i<triangleCount*3; ++i) {
+        auto v = indices[i];
+        adjacency[offsets[v] + live[v]++] = i / 3;
+    }
+
+    std::vector<int> cachePos(vertexCount, -1);
+    std::vector<float> vScores(vertexCount);
+    for(size_t v=0; v<vertexCount; ++v)
+        vScores[v] = vertexScore(-1, live[v]);
+
+    std::vector<float> tScores(triangleCount);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    for(size_t t=0; t<triangleCount; ++t)
+        tScores[t] = vScores[indices[t*3]] + vScores[indices[t*3 + 1]] + vScores[indices[t*3 + 2]];
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    std::array<uint32_t, CACHE_SIZE + 3> cache, newCache;
+    size_t cacheCount = 0, cursor = 0;
+    int64_t best = std::max_element(tScores.begin(), tScores.end()) - tScores.begin();
+
+    while(best >= 0) {
+        emitted[best] = 1;
+        auto tri = &indices[best * 3];
+
+        size_t newCount = 0;
+        for(int k=0; k<3; ++k) {
+            auto v = tri[k];
+            result.push_back(v);
+            newCache[newCount++] = v;
+
+            auto list = &adjacency[offsets[v]];
+            auto it = std::find(list, list + live[v], uint32_t(best));
+            std::swap(*it, list[live[v] - 1]);
+            live[v]--;
+        }
+
+        for(size_t i=0; i<cacheCount; ++i) {
+            auto v = cache[i];
+            if(v != tri[0] && v != tri[1] && v != tri[2])
+                newCache[newCount++] = v;
+        }
+
+        //Vertices pushed out of the cache are updated too, so their triangles lose the cache bonus
+        for(size_t i=0; i<newCount; ++i) {
+            auto v = newCache[i];
+            cachePos[v] = i < CACHE_SIZE? int(i) : -1;
+            vScores[v] = vertexScore(cachePos[v], live[v]);
+        }
+
+        best = -1;
+        float bestScore = -1.0f;
+        for(size_t i=0; i<newCount; ++i) {
+            auto v = newCache[i];
+            for(uint32_t j=0; j<live[v]; ++j) {
+                auto t = adjacency[offsets[v] + j];
+                tScores[t] = vScores[indices[t*3]] + vScores[indices[t*3 + 1]] + vScores[indices[t*3 + 2]];
+                if(tScores[t] > bestScore) {
+                    bestScore = tScores[t];
+                    best = t;
+                }
+            }
+        }
+
+        cacheCount = std::min<size_t>(newCount, CACHE_SIZE);
+        std::copy_n(newCache.begin(), cacheCount, cache.begin());
+
+        //Nothing left around the cache, the next triangle comes from the not emitted ones
+        if(best < 0) {
+            while(cursor < triangleCount && emitted[cursor])
+                cursor++;
+            if(cursor < triangleCount)
+                best = cursor;
+        }
+    }
+
+    indices = std::move(result);
+}
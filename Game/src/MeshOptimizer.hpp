@@ -0,0 +1,69 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <type_traits>
+
+//Post processing for the generated and loaded meshes, none of it touches the GPU
+
+namespace mesh {
+
+    //Post transform cache size the optimizer targets, modern GPUs behave close to a cache of this size
+    static constexpr int CACHE_SIZE = 32;
+
+    struct VertexCacheStats {
+        float acmr; //Vertex shader invocations per triangle, 0.5 is the best for a regular grid and 3 the worst
+        float atvr; //Vertex shader invocations per referenced vertex, 1 is the best
+    };
+
+    //Simulates a FIFO post transform cache of the given size, by default the one optimizeVertexCache targets
+    VertexCacheStats analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, int cacheSize = CACHE_SIZE);
+
+    //Reorders the triangles for post transform cache locality (Forsyth's linear speed optimizer)
+    void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    //Reorders the vertices in the order they're first used so vertex fetches are sequential, unused vertices are dropped
+    template<typename V>
+    void optimizeVertexFetch(std::vector<V>& vertices, std::vector<uint32_t>& indices) {
+        static constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> remap(vertices.size(), UNUSED);
+        std::vector<V> ordered;
+        ordered.reserve(vertices.size());
+
+        for(auto& i: indices) {
+            if(remap[i] == UNUSED) {
+                remap[i] = ordered.size();
+                ordered.push_back(vertices[i]);
+            }
+            i = remap[i];
+        }
+
+        vertices = std::move(ordered);
+    }
+
+    //Merges the vertices that are equal byte by byte, the vertex type must have no padding
+    template<typename V> requires std::is_trivially_copyable_v<V>
+    void deduplicateVertices(std::vector<V>& vertices, std::vector<uint32_t>& indices) {
+        auto bytes = [](const V& v){ return std::string_view(reinterpret_cast<const char*>(&v), sizeof(V)); };
+        std::unordered_map<std::string_view, uint32_t> unique;
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<V> merged;
+        merged.reserve(vertices.size());
+
+        for(size_t i=0; i<vertices.size(); ++i) {
+            auto [it, inserted] = unique.try_emplace(bytes(vertices[i]), uint32_t(merged.size()));
+            if(inserted)
+                merged.push_back(vertices[i]);
+            remap[i] = it->second;
+        }
+
+        for(auto& i: indices)
+            i = remap[i];
+        vertices = std::move(merged);
+    }
+
+}
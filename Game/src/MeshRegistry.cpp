@@ -0,0 +1,143 @@
+#include "MeshRegistry.hpp"
+#include "MeshOptimizer.hpp"
+#include "BinaryIO.hpp"
+#include "Telemetry.hpp"
+
+#include <tuple>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+
+static_assert(sizeof(fly::Vertex) % alignof(uint32_t) == 0, "indices must stay aligned after the vertices");
+
+std::shared_ptr<const MeshData> MeshRegistry::get(const fly::VulkanInstance& vk, const VkCommandPool commandPool, const std::filesystem::path& objPath) {
+    auto key = objPath.generic_string();
+    if(auto it = this->meshes.find(key); it != this->meshes.end())
+        return it->second;
+
+    auto cacheFile = cachePath(objPath);
+
+    std::shared_ptr<MeshData> mesh;
+    if(std::filesystem::exists(cacheFile))
+        mesh = mapCache(cacheFile, objPath);
+
+    if(!mesh) {
+        buildCache(vk, commandPool, objPath, cacheFile);
+        mesh = mapCache(cacheFile, objPath);
+        if(!mesh)
+            throw std::runtime_error("failed to build mesh cache for " + objPath.string());
+    }
+
+    this->meshes[key] = mesh;
+    return mesh;
+}
+
+std::unique_ptr<fly::VertexArray> MeshRegistry::createVertexArray(const fly::VulkanInstance& vk, const VkCommandPool commandPool, const MeshData& mesh) const {
+    std::vector<fly::Vertex> vertices(mesh.vertices.begin(), mesh.vertices.end());
+    std::vector<uint32_t> indices(mesh.indices.begin(), mesh.indices.end());
+    Telemetry::add(Metric::BYTES_UPLOADED, mesh.vertices.size_bytes() + mesh.indices.size_bytes());
+    return std::make_unique<fly::VertexArray>(vk, commandPool, std::move(vertices), std::move(indices));
+}
+
+void MeshRegistry::benchmark(const fly::VulkanInstance& vk, const VkCommandPool commandPool, const std::filesystem::path& objPath) {
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    auto model = loadModel(vk, commandPool, objPath);
+    std::chrono::duration<double, std::milli> parseTime = clock::now() - start;
+
+    this->get(vk, commandPool, objPath); //Makes sure the cache file exists
+
+    start = clock::now();
+    auto mesh = mapCache(cachePath(objPath), objPath);
+    auto vertexArray = this->createVertexArray(vk, commandPool, *mesh);
+    std::chrono::duration<double, std::milli> cacheTime = clock::now() - start;
+
+    std::cout << std::format("{}: OBJ {:.2f}ms ({} vertices) | cache {:.2f}ms ({} vertices)",
+        objPath.string(), parseTime.count(), model->getVertices().size(), cacheTime.count(), mesh->vertices.size()) << std::endl;
+}
+
+//Source files are identified by their size and modification time, which is much cheaper than hashing them
+static std::pair<uint64_t, int64_t> sourceStamp(const std::filesystem::path& objPath) {
+    return {std::filesystem::file_size(objPath), std::filesystem::last_write_time(objPath).time_since_epoch().count()};
+}
+
+std::filesystem::path MeshRegistry::cachePath(const std::filesystem::path& objPath) {
+    auto key = objPath.generic_string();
+    return CACHE_DIR / std::format("{:016x}.mesh", bin::fnv1a(key.data(), key.size()));
+}
+
+void MeshRegistry::buildCache(const fly::VulkanInstance& vk, const VkCommandPool commandPool, const std::filesystem::path& objPath, const std::filesystem::path& cacheFile) {
+    fly::ScopeTimer t("MESH CACHE BUILD");
+
+    auto model = loadModel(vk, commandPool, objPath);
+    auto vertices = model->getVertices();
+    auto indices = model->getIndices();
+    model.reset();
+
+    mesh::deduplicateVertices(vertices, indices);
+    mesh::optimizeVertexCache(indices, vertices.size());
+    mesh::optimizeVertexFetch(vertices, indices);
+
+    CacheHeader header{};
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.vertexSize = sizeof(fly::Vertex);
+    header.vertexCount = vertices.size();
+    header.indexCount = indices.size();
+    header.sourceHash = bin::hashFile(objPath);
+    std::tie(header.sourceSize, header.sourceWriteTime) = sourceStamp(objPath);
+
+    bin::Writer writer;
+    writer.write(header);
+    auto& data = writer.getData();
+    auto vertexBytes = reinterpret_cast<const char*>(vertices.data());
+    data.insert(data.end(), vertexBytes, vertexBytes + vertices.size() * sizeof(fly::Vertex));
+    auto indexBytes = reinterpret_cast<const char*>(indices.data());
+    data.insert(data.end(), indexBytes, indexBytes + indices.size() * sizeof(uint32_t));
+
+    std::filesystem::create_directories(CACHE_DIR);
+    writer.save(cacheFile);
+}
+
+std::shared_ptr<MeshData> MeshRegistry::mapCache(const std::filesystem::path& cacheFile, const std::filesystem::path& objPath) {
+    auto file = std::make_unique<MappedFile>(cacheFile);
+    if(file->size() < sizeof(CacheHeader))
+        return nullptr;
+
+    CacheHeader header;
+    std::memcpy(&header, file->data(), sizeof(header));
+    if(header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.vertexSize != sizeof(fly::Vertex))
+        return nullptr;
+
+    auto stamp = sourceStamp(objPath);
+    if(std::pair(header.sourceSize, header.sourceWriteTime) != stamp) {
+        if(header.sourceHash != bin::hashFile(objPath))
+            return nullptr;
+
+        //A touched but unchanged source still matches by content, its new stamp is written so later starts don't
+        //hash it again. The mapping is closed while writing, if the write fails the next start just hashes again
+        file.reset();
+        std::tie(header.sourceSize, header.sourceWriteTime) = stamp;
+        {
+            std::fstream cache(cacheFile, std::ios::binary | std::ios::in | std::ios::out);
+            cache.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        file = std::make_unique<MappedFile>(cacheFile);
+    }
+
+    auto vertexBytes = size_t(header.vertexCount) * sizeof(fly::Vertex);
+    auto indexBytes = size_t(header.indexCount) * sizeof(uint32_t);
+    if(file->size() != sizeof(CacheHeader) + vertexBytes + indexBytes)
+        return nullptr;
+
+    auto mesh = std::make_shared<MeshData>();
+    auto base = file->data() + sizeof(CacheHeader);
+    mesh->vertices = {reinterpret_cast<const fly::Vertex*>(base), header.vertexCount};
+    mesh->indices = {reinterpret_cast<const uint32_t*>(base + vertexBytes), header.indexCount};
+    mesh->file = std::move(file);
+
+    return mesh;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+#include <Engine.hpp>
+#include <span>
+#include <memory>
+#include <filesystem>
+#include <unordered_map>
+
+//Mesh kept in a memory mapped cache file, it stays alive while someone holds it
+struct MeshData {
+    std::span<const fly::Vertex> vertices;
+    std::span<const uint32_t> indices;
+    std::unique_ptr<MappedFile> file;
+};
+
+//Every model is parsed once into a deduplicated and optimized blob, later loads just map it and repeated requests
+//share the same CPU data. The cache is found by the source size and modification time, the content is only hashed
+//when those don't match. Only the CPU side is shared: every createVertexArray uploads its own GPU buffer
+class MeshRegistry {
+public:
+    inline static const std::filesystem::path CACHE_DIR = "cache";
+    static constexpr uint32_t CACHE_MAGIC = 0x4d594c46; //FLYM
+    static constexpr uint32_t CACHE_VERSION = 2;
+
+public:
+    MeshRegistry() = default;
+    ~MeshRegistry() = default;
+
+    std::shared_ptr<const MeshData> get(const fly::VulkanInstance& vk, const VkCommandPool commandPool, const std::filesystem::path& objPath);
+    std::unique_ptr<fly::VertexArray> createVertexArray(const fly::VulkanInstance& vk, const VkCommandPool commandPool, const MeshData& mesh) const;
+
+    //Prints the OBJ parse time against the cache load time
+    void benchmark(const fly::VulkanInstance& vk, const VkCommandPool commandPool, const std::filesystem::path& objPath);
+
+private:
+    struct CacheHeader {
+        uint32_t magic, version;
+        uint32_t vertexSize, vertexCount, indexCount, padding;
+        uint64_t sourceHash, sourceSize;
+        int64_t sourceWriteTime;
+    };
+
+    std::unordered_map<std::string, std::shared_ptr<const MeshData>> meshes;
+
+private:
+    static std::filesystem::path cachePath(const std::filesystem::path& objPath);
+    static void buildCache(const fly::VulkanInstance& vk, const VkCommandPool commandPool, const std::filesystem::path& objPath, const std::filesystem::path& cacheFile);
+    static std::shared_ptr<MeshData> mapCache(const std::filesystem::path& cacheFile, const std::filesystem::path& objPath);
+
+};
@@ -0,0 +1,328 @@
+#include "RoutePlanner.hpp"
+
+#include <queue>
+#include <tuple>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <algorithm>
+
+static constexpr float INF = std::numeric_limits<float>::infinity();
+
+void RoutePlanner::load(std::vector<City> cities) {
+    std::unique_lock lock(this->mutex);
+
+    this->cities = std::move(cities);
+    this->graph.assign(this->cities.size(), {});
+    this->cache.clear();
+    this->generation++;
+
+    this->hubs.clear();
+    for(int i=0; i<int(this->cities.size()); ++i) {
+        if(this->cities[i].capital)
+            this->hubs.push_back(i);
+    }
+
+    //Farthest point selection of the landmarks among the hubs, starting by the biggest one
+    this->landmarks.clear();
+    if(!this->hubs.empty()) {
+        auto first = *std::max_element(this->hubs.begin(), this->hubs.end(),
+            [this](int a, int b){ return this->cities[a].population < this->cities[b].population; });
+        this->landmarks.push_back(first);
+
+        std::vector<float> nearest(this->hubs.size(), INF);
+        while(this->landmarks.size() < std::min<size_t>(HUB_LANDMARKS, this->hubs.size())) {
+            auto last = this->cities[this->landmarks.back()].coord;
+            size_t farthest = 0;
+            for(size_t i=0; i<this->hubs.size(); ++i) {
+                nearest[i] = std::min(nearest[i], greatCircleDistance(last, this->cities[this->hubs[i]].coord));
+                if(nearest[i] > nearest[farthest])
+                    farthest = i;
+            }
+            this->landmarks.push_back(this->hubs[farthest]);
+        }
+    }
+
+    this->landmarksDirty = true;
+}
+
+void RoutePlanner::addRoute(int a, int b) {
+    if(a == b)
+        return;
+
+    //Checked under the same lock as the insertion so two concurrent adds can't duplicate the leg
+    std::unique_lock lock(this->mutex);
+    const auto& edges = this->graph.at(a);
+    if(std::any_of(edges.begin(), edges.end(), [b](const Edge& e){ return e.to == b; }))
+        return;
+
+    auto distance = greatCircleDistance(this->cities.at(a).coord, this->cities.at(b).coord);
+    this->graph[a].emplace_back(b, distance);
+    this->graph[b].emplace_back(a, distance);
+
+    this->invalidateAdded(a, b, distance);
+    this->generation++;
+    this->landmarksDirty = true;
+}
+
+void RoutePlanner::removeRoute(int a, int b) {
+    std::unique_lock lock(this->mutex);
+
+    auto erase = [this](int from, int to) {
+        auto& edges = this->graph.at(from);
+        auto it = std::find_if(edges.begin(), edges.end(), [to](const Edge& e){ return e.to == to; });
+        if(it == edges.end())
+            return false;
+        edges.erase(it);
+        return true;
+    };
+
+    if(erase(a, b) && erase(b, a)) {
+        this->invalidateRemoved(a, b);
+        this->generation++;
+        this->landmarksDirty = true;
+    }
+}
+
+bool RoutePlanner::hasRoute(int a, int b) const {
+    std::shared_lock lock(this->mutex);
+    const auto& edges = this->graph.at(a);
+    return std::any_of(edges.begin(), edges.end(), [b](const Edge& e){ return e.to == b; });
+}
+
+Route RoutePlanner::findRoute(int from, int to) {
+    if(from < 0 || to < 0 || from >= int(this->cities.size()) || to >= int(this->cities.size()))
+        throw std::runtime_error("city index out of range!");
+
+    this->refreshLandmarks();
+
+    Route route;
+    uint64_t searchGeneration;
+    {
+        std::shared_lock lock(this->mutex);
+        if(auto it = this->cache.find(cacheKey(from, to)); it != this->cache.end())
+            return it->second;
+
+        searchGeneration = this->generation;
+        route = this->search(from, to);
+    }
+
+    //If the network has changed while searching the route may be stale, so it's not cached
+    std::unique_lock lock(this->mutex);
+    if(searchGeneration == this->generation) {
+        if(this->cache.size() >= MAX_CACHED_ROUTES)
+            this->cache.clear();
+        this->cache[cacheKey(from, to)] = route;
+    }
+
+    return route;
+}
+
+std::vector<Route> RoutePlanner::findRoutes(const std::vector<std::pair<int, int>>& queries) {
+    std::vector<Route> routes(queries.size());
+    this->refreshLandmarks();
+
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+        for(size_t i; (i = next++) < queries.size();)
+            routes[i] = this->findRoute(queries[i].first, queries[i].second);
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        auto threads = std::max(1u, std::thread::hardware_concurrency());
+        for(unsigned t=1; t<threads && t<queries.size(); ++t)
+            workers.emplace_back(worker);
+        worker();
+    }
+
+    return routes;
+}
+
+double RoutePlanner::benchmark(size_t queries) const {
+    //Synthetic network: every city flies to a hub of its country and every hub to its nearest hubs
+    static constexpr int HUB_CONNECTIONS = 4;
+
+    RoutePlanner bench;
+    {
+        std::shared_lock lock(this->mutex);
+        bench.load(this->cities);
+    }
+
+    std::unordered_map<std::string, int> countryHub;
+    for(int i=0; i<int(bench.cities.size()); ++i) {
+        auto [it, inserted] = countryHub.try_emplace(bench.cities[i].country, i);
+        if(bench.cities[i].capital && !bench.cities[it->second].capital)
+            it->second = i;
+    }
+    for(int i=0; i<int(bench.cities.size()); ++i)
+        bench.addRoute(i, countryHub[bench.cities[i].country]);
+
+    for(auto& [country, hub]: countryHub) {
+        std::vector<std::pair<float, int>> nearest;
+        for(auto& [otherCountry, other]: countryHub) {
+            if(other != hub)
+                nearest.emplace_back(greatCircleDistance(bench.cities[hub].coord, bench.cities[other].coord), other);
+        }
+        auto count = std::min<size_t>(HUB_CONNECTIONS, nearest.size());
+        std::partial_sort(nearest.begin(), nearest.begin() + count, nearest.end());
+        for(size_t i=0; i<count; ++i)
+            bench.addRoute(hub, nearest[i].second);
+    }
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> city(0, int(bench.cities.size()) - 1);
+    std::vector<std::pair<int, int>> pairs(queries);
+    for(auto& p: pairs)
+        p = {city(rng), city(rng)};
+
+    bench.refreshLandmarks();
+    auto start = std::chrono::steady_clock::now();
+    bench.findRoutes(pairs);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    return queries / elapsed.count();
+}
+
+float RoutePlanner::greatCircleDistance(glm::vec2 a, glm::vec2 b) {
+    //Coords are stored as (longitude, latitude) in degrees
+    auto lat1 = glm::radians(a.y), lat2 = glm::radians(b.y);
+    auto dLat = lat2 - lat1;
+    auto dLon = glm::radians(b.x - a.x);
+
+    auto h = glm::sin(dLat/2) * glm::sin(dLat/2) + glm::cos(lat1) * glm::cos(lat2) * glm::sin(dLon/2) * glm::sin(dLon/2);
+    return 2 * EARTH_RADIUS * glm::asin(glm::sqrt(glm::clamp(h, 0.0f, 1.0f)));
+}
+
+void RoutePlanner::refreshLandmarks() {
+    if(!this->landmarksDirty)
+        return;
+
+    std::unique_lock lock(this->mutex);
+    if(!this->landmarksDirty)
+        return;
+
+    auto n = this->cities.size();
+    this->landmarkDistances.resize(this->landmarks.size() * n);
+    for(size_t l=0; l<this->landmarks.size(); ++l)
+        this->dijkstra(this->landmarks[l], this->landmarkDistances.data() + l*n);
+
+    this->landmarksDirty = false;
+}
+
+void RoutePlanner::dijkstra(int from, float* distances) const {
+    std::fill(distances, distances + this->cities.size(), INF);
+
+    using Entry = std::pair<float, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+    distances[from] = 0;
+    open.emplace(0.0f, from);
+
+    while(!open.empty()) {
+        auto [d, v] = open.top();
+        open.pop();
+        if(d > distances[v])
+            continue;
+
+        for(auto& e: this->graph[v]) {
+            if(d + e.distance < distances[e.to]) {
+                distances[e.to] = d + e.distance;
+                open.emplace(distances[e.to], e.to);
+            }
+        }
+    }
+}
+
+float RoutePlanner::heuristic(int v, int to) const {
+    auto h = greatCircleDistance(this->cities[v].coord, this->cities[to].coord);
+    if(this->landmarksDirty)
+        return h;
+
+    //Triangle inequality over the hub distances (ALT), an unreachable landmark on only one side means v can't reach the destination
+    auto n = this->cities.size();
+    for(size_t l=0; l<this->landmarks.size(); ++l) {
+        auto dv = this->landmarkDistances[l*n + v];
+        auto dt = this->landmarkDistances[l*n + to];
+        if(std::isinf(dv) != std::isinf(dt))
+            return INF;
+        if(!std::isinf(dv))
+            h = std::max(h, std::abs(dt - dv));
+    }
+
+    return h;
+}
+
+Route RoutePlanner::search(int from, int to) const {
+    Route route;
+    if(from == to) {
+        route.legs = {from};
+        route.distance = 0;
+        return route;
+    }
+
+    auto n = this->cities.size();
+    std::vector<float> distances(n, INF);
+    std::vector<int> parents(n, -1);
+
+    //Entries are (estimated total, distance from origin, city)
+    using Entry = std::tuple<float, float, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+    distances[from] = 0;
+    open.emplace(this->heuristic(from, to), 0.0f, from);
+
+    while(!open.empty()) {
+        auto [f, d, v] = open.top();
+        open.pop();
+        if(v == to)
+            break;
+        if(d > distances[v] || std::isinf(f))
+            continue;
+
+        for(auto& e: this->graph[v]) {
+            auto nd = d + e.distance;
+            if(nd < distances[e.to]) {
+                distances[e.to] = nd;
+                parents[e.to] = v;
+                open.emplace(nd + this->heuristic(e.to, to), nd, e.to);
+            }
+        }
+    }
+
+    if(std::isinf(distances[to]))
+        return route;
+
+    route.distance = distances[to];
+    for(int v = to; v != -1; v = parents[v])
+        route.legs.push_back(v);
+    std::reverse(route.legs.begin(), route.legs.end());
+
+    return route;
+}
+
+void RoutePlanner::invalidateAdded(int a, int b, float distance) {
+    //A cached route can only improve if the new leg can beat it even with great circle lower bounds around it
+    auto gc = [this](int u, int v){ return greatCircleDistance(this->cities[u].coord, this->cities[v].coord); };
+
+    std::erase_if(this->cache, [&](const auto& entry) {
+        auto from = int(entry.first >> 32), to = int(entry.first & 0xFFFFFFFF);
+        const auto& route = entry.second;
+        if(std::isinf(route.distance))
+            return true;
+
+        auto bound = std::min(gc(from, a) + distance + gc(b, to), gc(from, b) + distance + gc(a, to));
+        return bound < route.distance * (1 - 1e-6f);
+    });
+}
+
+void RoutePlanner::invalidateRemoved(int a, int b) {
+    //Only the routes flying through the removed leg change, unreachable ones stay unreachable
+    std::erase_if(this->cache, [a, b](const auto& entry) {
+        const auto& legs = entry.second.legs;
+        for(size_t i=1; i<legs.size(); ++i) {
+            if((legs[i-1] == a && legs[i] == b) || (legs[i-1] == b && legs[i] == a))
+                return true;
+        }
+        return false;
+    });
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "CitySpawner.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+#include <limits>
+
+struct Route {
+    std::vector<int> legs; //City indices from origin to destination, empty if it's unreachable
+    float distance = std::numeric_limits<float>::infinity(); //Kilometers
+};
+
+class RoutePlanner {
+public:
+    static constexpr float EARTH_RADIUS = 6371.0f; //Kilometers
+    static constexpr int HUB_LANDMARKS = 16;
+    static constexpr size_t MAX_CACHED_ROUTES = 1 << 16;
+
+public:
+    RoutePlanner() = default;
+    ~RoutePlanner() = default;
+
+    void load(std::vector<City> cities);
+
+    void addRoute(int a, int b);
+    void removeRoute(int a, int b);
+    bool hasRoute(int a, int b) const;
+
+    Route findRoute(int from, int to);
+    std::vector<Route> findRoutes(const std::vector<std::pair<int, int>>& queries);
+
+    //Returns the queries per second of cold queries over a synthetic hub network
+    double benchmark(size_t queries) const;
+
+    const std::vector<City>& getCities() const { return this->cities; }
+    const std::vector<int>& getHubs() const { return this->hubs; }
+
+    static float greatCircleDistance(glm::vec2 a, glm::vec2 b);
+
+private:
+    struct Edge {
+        int to;
+        float distance;
+    };
+
+    std::vector<City> cities;
+    std::vector<int> hubs;
+    std::vector<std::vector<Edge>> graph;
+
+    //Network distances from every landmark hub to every city, HUB_LANDMARKS * cities.size()
+    std::vector<int> landmarks;
+    std::vector<float> landmarkDistances;
+    std::atomic<bool> landmarksDirty = true;
+
+    std::unordered_map<uint64_t, Route> cache;
+    uint64_t generation = 0;
+    mutable std::shared_mutex mutex;
+
+private:
+    void refreshLandmarks();
+    void dijkstra(int from, float* distances) const;
+    float heuristic(int v, int to) const;
+    Route search(int from, int to) const;
+
+    void invalidateAdded(int a, int b, float distance);
+    void invalidateRemoved(int a, int b);
+
+    static uint64_t cacheKey(int from, int to) { return (uint64_t(uint32_t(from)) << 32) | uint32_t(to); }
+
+};
@@ -0,0 +1,143 @@
+#include "SaveManager.hpp"
+#include "BinaryIO.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+bool SaveManager::saveAsync(GameSnapshot snapshot) {
+    if(this->pending.valid() && this->pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        return false;
+
+    this->pending = std::async(std::launch::async, [this, snapshot = std::move(snapshot)]() {
+        try {
+            this->save(snapshot);
+        } catch(const std::exception& e) {
+            std::cerr << "Save failed: " << e.what() << std::endl;
+        }
+    });
+
+    return true;
+}
+
+void SaveManager::save(const GameSnapshot& snapshot) const {
+    bin::Writer writer;
+    writer.getData() = serialize(snapshot);
+    writer.save(this->path);
+}
+
+std::optional<GameSnapshot> SaveManager::load() const {
+    if(!this->exists())
+        return std::nullopt;
+
+    try {
+        auto data = bin::readFile(this->path);
+        return deserialize(data.data(), data.size());
+    } catch(const std::exception& e) {
+        std::cerr << "Load failed: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+std::vector<char> SaveManager::serialize(const GameSnapshot& snapshot) {
+    bin::Writer writer;
+    writer.write(SAVE_MAGIC);
+    writer.write(SAVE_VERSION);
+    writer.write(uint32_t(3));
+
+    //Every section is its tag, its size and the payload
+    auto section = [&writer](Section tag, auto&& writePayload) {
+        writer.write(tag);
+        auto sizeOffset = writer.getData().size();
+        writer.write(uint32_t(0));
+
+        writePayload();
+
+        uint32_t size = writer.getData().size() - sizeOffset - sizeof(uint32_t);
+        std::memcpy(writer.getData().data() + sizeOffset, &size, sizeof(size));
+    };
+
+    section(Section::COUNTRIES, [&]() {
+        writer.write(uint32_t(snapshot.countryCodes->size()));
+        for(auto& c: *snapshot.countryCodes)
+            writer.write(c);
+        writer.write(snapshot.countryStates);
+    });
+
+    section(Section::SPAWNER, [&]() {
+        //The text form is defined by the standard, the object layout changes between standard libraries
+        std::ostringstream generator;
+        generator << snapshot.spawner.generator;
+        writer.write(generator.str());
+        writer.write(snapshot.spawner.possibleCountries);
+        writer.write(snapshot.spawner.pendingCities);
+    });
+
+    section(Section::GAME, [&]() {
+        writer.write(snapshot.totalTime);
+    });
+
+    return std::move(writer.getData());
+}
+
+GameSnapshot SaveManager::deserialize(const char* data, size_t size) {
+    bin::Reader reader(data, size);
+    if(reader.read<uint32_t>() != SAVE_MAGIC)
+        throw std::runtime_error("not a save file!");
+    if(reader.read<uint32_t>() != SAVE_VERSION)
+        throw std::runtime_error("unsupported save version!");
+
+    GameSnapshot snapshot;
+    auto sections = reader.read<uint32_t>();
+    for(uint32_t i=0; i<sections; ++i) {
+        auto tag = reader.read<Section>();
+        auto sectionSize = reader.read<uint32_t>();
+        bin::Reader payload(reader.take(sectionSize), sectionSize);
+
+        switch(tag) {
+        case Section::COUNTRIES: {
+            //Every code takes at least its length, so a corrupted count fails before allocating
+            auto count = payload.read<uint32_t>();
+            if(count > payload.remaining() / sizeof(uint32_t))
+                throw std::runtime_error("corrupted save file!");
+            auto codes = std::make_shared<std::vector<std::string>>(count);
+            for(auto& c: *codes)
+                c = payload.readString();
+            snapshot.countryCodes = std::move(codes);
+            snapshot.countryStates = payload.readVector<CountryState>();
+            break;
+        }
+        case Section::SPAWNER: {
+            std::istringstream generator(payload.readString());
+            if(!(generator >> snapshot.spawner.generator))
+                throw std::runtime_error("corrupted save file!");
+            snapshot.spawner.possibleCountries = payload.readVector<SavedUnlockableCity>();
+            snapshot.spawner.pendingCities = payload.readVector<CityRef>();
+            break;
+        }
+        case Section::GAME:
+            snapshot.totalTime = payload.read<double>();
+            break;
+        default:
+            break;
+        }
+    }
+
+    if(!snapshot.countryCodes || snapshot.countryCodes->size() != snapshot.countryStates.size())
+        throw std::runtime_error("corrupted save file!");
+
+    auto validState = [](CountryState s){ return s >= CountryState::LOCKED && s <= CountryState::HOVERED; };
+    if(!std::all_of(snapshot.countryStates.begin(), snapshot.countryStates.end(), validState))
+        throw std::runtime_error("corrupted save file!");
+
+    //City indices are checked against the loaded cities when restoring, here only the country table is known
+    auto validRef = [&snapshot](CityRef ref){ return ref.country < snapshot.countryCodes->size(); };
+    for(auto& p: snapshot.spawner.possibleCountries) {
+        if(!validRef(p.next))
+            throw std::runtime_error("corrupted save file!");
+    }
+    if(!std::all_of(snapshot.spawner.pendingCities.begin(), snapshot.spawner.pendingCities.end(), validRef))
+        throw std::runtime_error("corrupted save file!");
+
+    return snapshot;
+}
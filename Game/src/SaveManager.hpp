@@ -0,0 +1,44 @@
+#pragma once
+
+#include "CitySpawner.hpp"
+
+#include <memory>
+#include <future>
+#include <optional>
+#include <filesystem>
+
+//Everything a save needs, captured on the main thread and serialized on the background
+struct GameSnapshot {
+    std::shared_ptr<const std::vector<std::string>> countryCodes; //Sorted, shared by every snapshot as it never changes
+    std::vector<CountryState> countryStates; //Parallel to countryCodes
+    CitySpawnerSave spawner;
+    double totalTime = 0;
+};
+
+class SaveManager {
+public:
+    static constexpr uint32_t SAVE_MAGIC = 0x53594c46; //FLYS
+    static constexpr uint32_t SAVE_VERSION = 2; //2 stores the generator in its portable text form
+
+    //Tags of the save sections, unknown ones are skipped so new sections don't break old saves
+    enum class Section: uint32_t { COUNTRIES = 1, SPAWNER = 2, GAME = 3, FLIGHTS = 4 };
+
+public:
+    SaveManager(std::filesystem::path path): path{std::move(path)} {}
+    ~SaveManager() = default; //The pending future waits for the last save
+
+    //Returns false if the last save is still being written
+    bool saveAsync(GameSnapshot snapshot);
+    void save(const GameSnapshot& snapshot) const;
+    std::optional<GameSnapshot> load() const;
+
+    bool exists() const { return std::filesystem::exists(this->path); }
+
+    static std::vector<char> serialize(const GameSnapshot& snapshot);
+    static GameSnapshot deserialize(const char* data, size_t size);
+
+private:
+    std::filesystem::path path;
+    std::future<void> pending;
+
+};
@@ -0,0 +1,130 @@
+#include "Telemetry.hpp"
+
+#include <new>
+#include <cmath>
+#include <limits>
+#include <chrono>
+#include <iomanip>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+void Telemetry::sample(double time) {
+    if(!running.load(std::memory_order_relaxed))
+        return;
+
+    //Single producer ring, if the writer falls behind the sample is dropped instead of waiting
+    auto h = head.load(std::memory_order_relaxed);
+    if(h - tail.load(std::memory_order_acquire) >= RING_SIZE) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto& s = ring[h % RING_SIZE];
+    s.time = time;
+    for(size_t i=0; i<METRIC_COUNT; ++i)
+        s.values[i] = values[i].load(std::memory_order_relaxed);
+    s.values[size_t(Metric::ALLOCATIONS)] = double(allocations.load(std::memory_order_relaxed));
+    s.values[size_t(Metric::ALLOCATED_BYTES)] = double(allocatedBytes.load(std::memory_order_relaxed));
+    s.values[size_t(Metric::FREES)] = double(frees.load(std::memory_order_relaxed));
+
+    head.store(h + 1, std::memory_order_release);
+}
+
+void Telemetry::start(const std::filesystem::path& path) {
+    stop();
+    tail.store(head.load());
+    running = true;
+    writer = std::jthread(writeLoop, path);
+}
+
+void Telemetry::stop() {
+    running = false;
+    if(writer.joinable()) {
+        writer.request_stop();
+        writer.join();
+    }
+}
+
+void Telemetry::writeLoop(std::stop_token stop, std::filesystem::path path) {
+    static constexpr auto WRITE_PERIOD = std::chrono::milliseconds(100);
+
+    std::ofstream file(path, std::ios::trunc);
+    if(!file.is_open()) {
+        std::cerr << "failed to open telemetry file " << path << std::endl;
+        running = false;
+        return;
+    }
+
+    //Enough digits to round trip, so long runs keep distinct timestamps and big counters stay exact
+    file << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+    bool jsonl = path.extension() == ".jsonl";
+    auto write = [&](double v) {
+        if(jsonl && !std::isfinite(v))
+            file << "null";
+        else
+            file << v;
+    };
+
+    if(!jsonl) {
+        file << "time";
+        for(auto name: METRIC_NAMES)
+            file << ',' << name;
+        file << '\n';
+    }
+
+    auto flush = [&]() {
+        auto t = tail.load(std::memory_order_relaxed);
+        auto h = head.load(std::memory_order_acquire);
+        for(; t < h; ++t) {
+            auto& s = ring[t % RING_SIZE];
+            if(jsonl) {
+                file << "{\"time\":";
+                write(s.time);
+                for(size_t i=0; i<METRIC_COUNT; ++i) {
+                    file << ",\"" << METRIC_NAMES[i] << "\":";
+                    write(s.values[i]);
+                }
+                file << "}\n";
+            } else {
+                write(s.time);
+                for(auto v: s.values) {
+                    file << ',';
+                    write(v);
+                }
+                file << '\n';
+            }
+        }
+        tail.store(t, std::memory_order_release);
+        file.flush();
+    };
+
+    while(!stop.stop_requested()) {
+        flush();
+        std::this_thread::sleep_for(WRITE_PERIOD);
+    }
+    flush();
+}
+
+
+//GLOBAL ALLOCATION COUNTING
+void* operator new(size_t size) {
+    Telemetry::countAllocation(size);
+
+    if(auto ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    if(ptr)
+        Telemetry::countFree();
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    if(ptr)
+        Telemetry::countFree();
+    std::free(ptr);
+}
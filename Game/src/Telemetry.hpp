@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <filesystem>
+
+enum class Metric: uint32_t {
+    FRAME_TIME,         //Gauge, milliseconds
+    DRAWS,              //Gauge, the draws the game submits
+    TRIANGLES,          //Gauge, of the meshes the game attaches
+    BYTES_UPLOADED,     //Counter
+    CITIES_SPAWNED,     //Counter
+    UNLOCKED_COUNTRIES, //Gauge
+    SPAWNER_CALLS,      //Counter
+    ALLOCATIONS,        //Counter, only while telemetry runs
+    ALLOCATED_BYTES,    //Counter, only while telemetry runs
+    FREES,              //Counter, only while telemetry runs, allocations - frees are the live allocations
+    COUNT
+};
+
+//Counters and gauges that can be updated from any thread without locks, sampled once per frame into a ring
+//that a background thread streams to a CSV or JSONL file (chosen by the extension)
+class Telemetry {
+public:
+    static constexpr size_t METRIC_COUNT = size_t(Metric::COUNT);
+    static constexpr size_t RING_SIZE = 1024; //Samples, around 17 seconds at 60 FPS
+    static constexpr std::array<const char*, METRIC_COUNT> METRIC_NAMES = {
+        "frame_time_ms", "draws", "triangles", "bytes_uploaded", "cities_spawned",
+        "unlocked_countries", "spawner_calls", "allocations", "allocated_bytes", "frees"
+    };
+
+public:
+    static void add(Metric metric, double value = 1) { values[size_t(metric)].fetch_add(value, std::memory_order_relaxed); }
+    static void set(Metric metric, double value) { values[size_t(metric)].store(value, std::memory_order_relaxed); }
+    static double get(Metric metric) { return values[size_t(metric)].load(std::memory_order_relaxed); }
+
+    //Only the main thread should sample
+    static void sample(double time);
+
+    static void start(const std::filesystem::path& path);
+    static void stop();
+
+    static uint64_t getDroppedSamples() { return dropped.load(std::memory_order_relaxed); }
+
+    //Called by the global operator new and delete, they only do an integer add while telemetry runs
+    static void countAllocation(size_t size) {
+        if(running.load(std::memory_order_relaxed)) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+            allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+    static void countFree() {
+        if(running.load(std::memory_order_relaxed))
+            frees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+private:
+    struct Sample {
+        double time;
+        std::array<double, METRIC_COUNT> values;
+    };
+
+    inline static std::array<std::atomic<double>, METRIC_COUNT> values = {};
+    inline static std::atomic<uint64_t> allocations = 0, allocatedBytes = 0, frees = 0;
+
+    inline static std::array<Sample, RING_SIZE> ring;
+    inline static std::atomic<uint64_t> head = 0, tail = 0, dropped = 0;
+    inline static std::atomic<bool> running = false;
+    inline static std::jthread writer;
+
+private:
+    static void writeLoop(std::stop_token stop, std::filesystem::path path);
+
+};
@@ -0,0 +1,212 @@
+#include "ViewState.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define FLY_SSE
+#include <emmintrin.h>
+#endif
+
+ViewState ViewState::create(const glm::mat4& proj, const glm::mat4& view, glm::vec2 screenSize) {
+    ViewState state;
+    state.viewProj = proj * view;
+    state.invViewProj = glm::inverse(state.viewProj);
+    state.cameraPos = glm::vec3(glm::inverse(view)[3]);
+    state.screenSize = screenSize;
+
+    //Gribb-Hartmann plane extraction with a [0, 1] depth range
+    auto row = [&m = state.viewProj](int i){ return glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]); };
+    state.frustum = { row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(2), row(3) - row(2) };
+    for(auto& p: state.frustum)
+        p /= glm::length(glm::vec3(p));
+
+    return state;
+}
+
+Ray ViewState::mouseRay(glm::vec2 mousePos) const {
+    float xNdc = (mousePos.x / this->screenSize.x - 0.5f) * 2.0f;
+    float yNdc = (mousePos.y / this->screenSize.y - 0.5f) * 2.0f;
+
+    glm::vec4 rayStart = this->invViewProj * glm::vec4(xNdc, yNdc, -1.0f, 1.0f);
+    rayStart /= rayStart.w;
+    glm::vec4 rayEnd = this->invViewProj * glm::vec4(xNdc, yNdc, 0.0f, 1.0f);
+    rayEnd /= rayEnd.w;
+
+    glm::vec3 rayDir = glm::normalize(glm::vec3(rayEnd - rayStart));
+
+    return Ray {rayStart, rayDir};
+}
+
+bool ViewState::isSphereVisible(glm::vec3 center, float radius) const {
+    for(auto& p: this->frustum) {
+        if(glm::dot(glm::vec3(p), center) + p.w < -radius)
+            return false;
+    }
+    return true;
+}
+
+glm::vec3 intersectRayUnitSphere(Ray r) {
+    float b = glm::dot(r.origin, r.direction); 
+    float c = glm::dot(r.origin, r.origin) - 1; 
+
+    if (c > 0.0f && b > 0.0f) 
+        return glm::vec3(0, 0, 0); 
+    float discr = b*b - c; 
+
+    if (discr < 0.0f) 
+        return glm::vec3(0, 0, 0);
+
+    float t = -b - glm::sqrt(discr); 
+
+    if (t < 0.0f) t = 0.0f; 
+    glm::vec3 q = r.origin + t * r.direction; 
+
+    return q;
+}
+
+//Scalar versions, used for the tails of the batches and when SSE isn't available
+static void projectOne(const ViewState& state, glm::vec3 point, glm::vec2& screen, uint8_t& visible) {
+    auto clip = state.viewProj * glm::vec4(point, 1.0f);
+    auto ndc = glm::vec2(clip.x, clip.y) / clip.w;
+    screen = (ndc * 0.5f + 0.5f) * state.screenSize;
+    visible = glm::dot(point, state.cameraPos) > 1.0f && clip.w > 0 && glm::abs(ndc.x) <= 1 && glm::abs(ndc.y) <= 1;
+}
+
+static void intersectOne(Ray r, glm::vec3& point, uint8_t& hit) {
+    point = intersectRayUnitSphere(r);
+    hit = point != glm::vec3(0, 0, 0);
+}
+
+#ifdef FLY_SSE
+
+//Column major matrix times (x, y, z, 1) for 4 points
+static void transform4(const glm::mat4& m, __m128 x, __m128 y, __m128 z, __m128 out[4]) {
+    for(int k=0; k<4; ++k) {
+        out[k] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0][k]), x), _mm_mul_ps(_mm_set1_ps(m[1][k]), y)),
+            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[2][k]), z), _mm_set1_ps(m[3][k]))
+        );
+    }
+}
+
+void ViewState::mouseRays(std::span<const glm::vec2> mousePos, RayBatch& rays) const {
+    rays.resize(mousePos.size());
+
+    auto two = _mm_set1_ps(2.0f), half = _mm_set1_ps(0.5f);
+    auto invW = _mm_set1_ps(1.0f / this->screenSize.x), invH = _mm_set1_ps(1.0f / this->screenSize.y);
+
+    size_t i = 0;
+    for(; i+4 <= mousePos.size(); i+=4) {
+        auto px = _mm_setr_ps(mousePos[i].x, mousePos[i+1].x, mousePos[i+2].x, mousePos[i+3].x);
+        auto py = _mm_setr_ps(mousePos[i].y, mousePos[i+1].y, mousePos[i+2].y, mousePos[i+3].y);
+        auto x = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(px, invW), half), two);
+        auto y = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(py, invH), half), two);
+
+        __m128 start[4], end[4];
+        transform4(this->invViewProj, x, y, _mm_set1_ps(-1.0f), start);
+        transform4(this->invViewProj, x, y, _mm_setzero_ps(), end);
+
+        __m128 o[3], d[3];
+        for(int k=0; k<3; ++k) {
+            o[k] = _mm_div_ps(start[k], start[3]);
+            d[k] = _mm_sub_ps(_mm_div_ps(end[k], end[3]), o[k]);
+        }
+        auto len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(d[0], d[0]), _mm_mul_ps(d[1], d[1])), _mm_mul_ps(d[2], d[2])));
+
+        _mm_storeu_ps(&rays.ox[i], o[0]);
+        _mm_storeu_ps(&rays.oy[i], o[1]);
+        _mm_storeu_ps(&rays.oz[i], o[2]);
+        _mm_storeu_ps(&rays.dx[i], _mm_div_ps(d[0], len));
+        _mm_storeu_ps(&rays.dy[i], _mm_div_ps(d[1], len));
+        _mm_storeu_ps(&rays.dz[i], _mm_div_ps(d[2], len));
+    }
+
+    for(; i<mousePos.size(); ++i)
+        rays.set(i, this->mouseRay(mousePos[i]));
+}
+
+void ViewState::project(std::span<const glm::vec3> points, std::span<glm::vec2> screen, std::span<uint8_t> visible) const {
+    auto one = _mm_set1_ps(1.0f), half = _mm_set1_ps(0.5f), zero = _mm_setzero_ps();
+    auto signMask = _mm_set1_ps(-0.0f);
+    auto width = _mm_set1_ps(this->screenSize.x), height = _mm_set1_ps(this->screenSize.y);
+
+    size_t i = 0;
+    for(; i+4 <= points.size(); i+=4) {
+        auto x = _mm_setr_ps(points[i].x, points[i+1].x, points[i+2].x, points[i+3].x);
+        auto y = _mm_setr_ps(points[i].y, points[i+1].y, points[i+2].y, points[i+3].y);
+        auto z = _mm_setr_ps(points[i].z, points[i+1].z, points[i+2].z, points[i+3].z);
+
+        __m128 clip[4];
+        transform4(this->viewProj, x, y, z, clip);
+        auto ndcX = _mm_div_ps(clip[0], clip[3]);
+        auto ndcY = _mm_div_ps(clip[1], clip[3]);
+
+        //A point of the unit sphere is only visible if it's in front of the horizon plane
+        auto horizon = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(x, _mm_set1_ps(this->cameraPos.x)), _mm_mul_ps(y, _mm_set1_ps(this->cameraPos.y))),
+            _mm_mul_ps(z, _mm_set1_ps(this->cameraPos.z)));
+        auto mask = _mm_and_ps(_mm_cmpgt_ps(horizon, one), _mm_cmpgt_ps(clip[3], zero));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_andnot_ps(signMask, ndcX), one));
+        mask = _mm_and_ps(mask, _mm_cmple_ps(_mm_andnot_ps(signMask, ndcY), one));
+        auto bits = _mm_movemask_ps(mask);
+
+        alignas(16) float sx[4], sy[4];
+        _mm_store_ps(sx, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndcX, half), half), width));
+        _mm_store_ps(sy, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndcY, half), half), height));
+        for(int k=0; k<4; ++k) {
+            screen[i + k] = {sx[k], sy[k]};
+            visible[i + k] = (bits >> k) & 1;
+        }
+    }
+
+    for(; i<points.size(); ++i)
+        projectOne(*this, points[i], screen[i], visible[i]);
+}
+
+void intersectRaysUnitSphere(const RayBatch& rays, std::span<glm::vec3> points, std::span<uint8_t> hit) {
+    auto zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+
+    size_t i = 0;
+    for(; i+4 <= rays.size(); i+=4) {
+        auto ox = _mm_loadu_ps(&rays.ox[i]), oy = _mm_loadu_ps(&rays.oy[i]), oz = _mm_loadu_ps(&rays.oz[i]);
+        auto dx = _mm_loadu_ps(&rays.dx[i]), dy = _mm_loadu_ps(&rays.dy[i]), dz = _mm_loadu_ps(&rays.dz[i]);
+
+        auto b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, dx), _mm_mul_ps(oy, dy)), _mm_mul_ps(oz, dz));
+        auto c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)), _mm_mul_ps(oz, oz)), one);
+        auto discr = _mm_sub_ps(_mm_mul_ps(b, b), c);
+
+        auto miss = _mm_or_ps(_mm_and_ps(_mm_cmpgt_ps(c, zero), _mm_cmpgt_ps(b, zero)), _mm_cmplt_ps(discr, zero));
+        auto t = _mm_max_ps(_mm_sub_ps(_mm_sub_ps(zero, b), _mm_sqrt_ps(_mm_max_ps(discr, zero))), zero);
+
+        alignas(16) float qx[4], qy[4], qz[4];
+        _mm_store_ps(qx, _mm_andnot_ps(miss, _mm_add_ps(ox, _mm_mul_ps(t, dx))));
+        _mm_store_ps(qy, _mm_andnot_ps(miss, _mm_add_ps(oy, _mm_mul_ps(t, dy))));
+        _mm_store_ps(qz, _mm_andnot_ps(miss, _mm_add_ps(oz, _mm_mul_ps(t, dz))));
+        auto bits = _mm_movemask_ps(miss);
+        for(int k=0; k<4; ++k) {
+            points[i + k] = {qx[k], qy[k], qz[k]};
+            hit[i + k] = !((bits >> k) & 1);
+        }
+    }
+
+    for(; i<rays.size(); ++i)
+        intersectOne(rays.get(i), points[i], hit[i]);
+}
+
+#else
+
+void ViewState::mouseRays(std::span<const glm::vec2> mousePos, RayBatch& rays) const {
+    rays.resize(mousePos.size());
+    for(size_t i=0; i<mousePos.size(); ++i)
+        rays.set(i, this->mouseRay(mousePos[i]));
+}
+
+void ViewState::project(std::span<const glm::vec3> points, std::span<glm::vec2> screen, std::span<uint8_t> visible) const {
+    for(size_t i=0; i<points.size(); ++i)
+        projectOne(*this, points[i], screen[i], visible[i]);
+}
+
+void intersectRaysUnitSphere(const RayBatch& rays, std::span<glm::vec3> points, std::span<uint8_t> hit) {
+    for(size_t i=0; i<rays.size(); ++i)
+        intersectOne(rays.get(i), points[i], hit[i]);
+}
+
+#endif
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <span>
+#include <array>
+#include <vector>
+#include <cstdint>
+
+struct Ray {
+    glm::vec3 origin, direction;
+};
+
+//Rays in structure of arrays layout so they can be processed 4 at a time
+struct RayBatch {
+    std::vector<float> ox, oy, oz, dx, dy, dz;
+
+    void resize(size_t n) {
+        for(auto v: {&ox, &oy, &oz, &dx, &dy, &dz})
+            v->resize(n);
+    }
+    size_t size() const { return this->ox.size(); }
+
+    Ray get(size_t i) const { return Ray{{ox[i], oy[i], oz[i]}, {dx[i], dy[i], dz[i]}}; }
+    void set(size_t i, Ray r) {
+        ox[i] = r.origin.x; oy[i] = r.origin.y; oz[i] = r.origin.z;
+        dx[i] = r.direction.x; dy[i] = r.direction.y; dz[i] = r.direction.z;
+    }
+};
+
+//Everything derived from the camera matrices, computed once per camera update so ray queries don't invert matrices
+struct ViewState {
+    glm::mat4 viewProj = glm::mat4(1.0f), invViewProj = glm::mat4(1.0f);
+    std::array<glm::vec4, 6> frustum; //Normals point inside, left, right, bottom, top, near and far
+    glm::vec3 cameraPos = {0, 0, 0};
+    glm::vec2 screenSize = {1, 1};
+
+    static ViewState create(const glm::mat4& proj, const glm::mat4& view, glm::vec2 screenSize);
+
+    Ray mouseRay(glm::vec2 mousePos) const;
+    void mouseRays(std::span<const glm::vec2> mousePos, RayBatch& rays) const;
+
+    //Points of the unit sphere to pixels, visible is 0 for the ones behind the horizon or off the screen
+    void project(std::span<const glm::vec3> points, std::span<glm::vec2> screen, std::span<uint8_t> visible) const;
+
+    //Conservative, a sphere near a frustum corner can pass without being on screen
+    bool isSphereVisible(glm::vec3 center, float radius) const;
+};
+
+//Closest point of the unit sphere along the ray, (0, 0, 0) if it misses
+glm::vec3 intersectRayUnitSphere(Ray ray);
+
+//Same results as intersectRayUnitSphere, misses are (0, 0, 0) with hit set to 0
+void intersectRaysUnitSphere(const RayBatch& rays, std::span<glm::vec3> points, std::span<uint8_t> hit);
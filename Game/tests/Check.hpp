@@ -0,0 +1,13 @@
+#pragma once
+
+#include <iostream>
+
+//Minimal assertion for the headless tests, it keeps going so every failure of a run is reported
+inline int failures = 0;
+
+#define CHECK(expr) do { \
+    if(!(expr)) { \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #expr ") failed" << std::endl; \
+        ++failures; \
+    } \
+} while(0)
@@ -0,0 +1,110 @@
+#include "CountryGraph.hpp"
+#include "BinaryIO.hpp"
+#include "Check.hpp"
+
+#include <vector>
+#include <filesystem>
+
+//Square country of the given size whose border is sampled every 0.1 degrees
+static void addSquare(std::unordered_map<std::string, Country>& countries, std::vector<glm::vec2>& vertices, const std::string& code, glm::vec2 corner, float size) {
+    auto begin = uint32_t(vertices.size());
+    int steps = int(size * 10);
+    for(int i=0; i<=steps; ++i) {
+        float t = size * i / steps;
+        vertices.push_back(corner + glm::vec2(t, 0));
+        vertices.push_back(corner + glm::vec2(t, size));
+        vertices.push_back(corner + glm::vec2(0, t));
+        vertices.push_back(corner + glm::vec2(size, t));
+    }
+    countries[code].vertexRanges.emplace_back(begin, uint32_t(vertices.size()));
+}
+
+int main() {
+    std::unordered_map<std::string, Country> countries;
+    std::vector<glm::vec2> vertices;
+    addSquare(countries, vertices, "AAA", {0, 0}, 1);
+    addSquare(countries, vertices, "BBB", {1, 0}, 1);          //Shares AAA's east border
+    addSquare(countries, vertices, "CCC", {0, 1.02f}, 1);      //North of AAA, within the tolerance
+    addSquare(countries, vertices, "DDD", {5, 5}, 1);          //Isolated island
+    addSquare(countries, vertices, "EEE", {179, 10}, 1);       //Touches FFF across the antimeridian
+    addSquare(countries, vertices, "FFF", {-180, 10}, 1);
+    addSquare(countries, vertices, "GGG", {1, 1.5f}, 1);       //0.5 degrees north of BBB, too far to be a neighbour
+    addSquare(countries, vertices, "III", {9, 9}, 1);
+    addSquare(countries, vertices, "JJJ", {10.09f, 10.09f}, 1); //Corner 0.09 degrees off on both axes, in adjacent cells but 2.5 times the tolerance away
+    addSquare(countries, vertices, "KKK", {20, 70}, 1);
+    addSquare(countries, vertices, "LLL", {21.14f, 70}, 1);     //0.14 degrees of longitude east of KKK, under the tolerance at 70 degrees north
+
+    //A country with two disjoint sub-meshes, the second one borders DDD
+    addSquare(countries, vertices, "HHH", {-20, -20}, 1);
+    addSquare(countries, vertices, "TMP", {6, 5}, 1);
+    countries["HHH"].vertexRanges.push_back(countries["TMP"].vertexRanges[0]);
+    countries.erase("TMP");
+
+    CountryGraph graph;
+    graph.build(countries, vertices);
+
+    CHECK(graph.size() == countries.size());
+    CHECK(graph.areNeighbours("AAA", "BBB"));
+    CHECK(graph.areNeighbours("BBB", "AAA"));
+    CHECK(graph.areNeighbours("AAA", "CCC"));
+    CHECK(graph.areNeighbours("EEE", "FFF"));
+    CHECK(graph.areNeighbours("FFF", "EEE"));
+    CHECK(graph.areNeighbours("DDD", "HHH"));
+    CHECK(!graph.areNeighbours("AAA", "DDD"));
+    CHECK(!graph.areNeighbours("BBB", "GGG"));
+    CHECK(!graph.areNeighbours("III", "JJJ"));
+    CHECK(graph.areNeighbours("KKK", "LLL"));
+    CHECK(graph.areNeighbours("LLL", "KKK"));
+    CHECK(!graph.areNeighbours("AAA", "AAA"));
+    CHECK(!graph.areNeighbours("AAA", "ZZZ"));
+    CHECK(graph.getIndex("ZZZ") == -1);
+
+    //Neighbour lists are symmetric and free of duplicates
+    for(uint32_t i=0; i<graph.size(); ++i) {
+        auto neighbours = graph.getNeighbours(i);
+        for(size_t j=0; j<neighbours.size(); ++j) {
+            CHECK(graph.areNeighbours(graph.getCountry(neighbours[j]), graph.getCountry(i)));
+            if(j > 0)
+                CHECK(neighbours[j - 1] < neighbours[j]);
+        }
+    }
+
+    //The cache round trips and is rejected when the source data changes
+    auto path = std::filesystem::temp_directory_path() / "fly_country_graph_test.adj";
+    graph.save(path, 7);
+    CountryGraph cached;
+    CHECK(!cached.load(path, 8));
+    CHECK(cached.load(path, 7));
+    CHECK(cached.size() == graph.size());
+    CHECK(cached.areNeighbours("EEE", "FFF"));
+    CHECK(!cached.areNeighbours("AAA", "DDD"));
+
+    //Corrupted caches are rejected instead of crashing or pointing past the countries
+    auto writeCache = [&](uint32_t count, std::vector<uint32_t> offsets, std::vector<uint32_t> neighbours) {
+        bin::Writer writer;
+        writer.write(CountryGraph::CACHE_MAGIC);
+        writer.write(CountryGraph::CACHE_VERSION);
+        writer.write(uint64_t(7));
+        writer.write(count);
+        for(uint32_t i=0; i<std::min(count, 2u); ++i)
+            writer.write(std::string(1, char('A' + i)));
+        writer.write(offsets);
+        writer.write(neighbours);
+        writer.save(path);
+    };
+    writeCache(2, {0, 1, 2}, {1, 0});
+    CHECK(cached.load(path, 7));
+    CHECK(cached.areNeighbours("A", "B"));
+    writeCache(0xFFFFFFF0, {0, 1, 2}, {1, 0});
+    CHECK(!cached.load(path, 7));
+    writeCache(2, {0, 1, 2}, {5, 0});
+    CHECK(!cached.load(path, 7));
+    writeCache(2, {0, 2, 1}, {1, 0});
+    CHECK(!cached.load(path, 7));
+    writeCache(2, {1, 1, 2}, {1, 0});
+    CHECK(!cached.load(path, 7));
+    CHECK(cached.areNeighbours("A", "B")); //A rejected cache leaves the graph untouched
+    std::filesystem::remove(path);
+
+    return failures == 0? 0 : 1;
+}
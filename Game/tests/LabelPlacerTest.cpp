@@ -0,0 +1,137 @@
+#include "CityLabels.hpp"
+#include "EarthCamera.hpp"
+#include "Check.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+static const glm::vec2 SCREEN = {1280, 720};
+static const float FONT_SIZE = CityLabels::FONT_SIZE;
+
+//Same matrices EarthCamera::update builds
+static ViewState makeView(glm::vec3 normPos, float height) {
+    auto view = glm::lookAt(height * normPos, glm::vec3(0.0f), EarthCamera::UP);
+    auto proj = glm::perspective(glm::radians(45.0f), SCREEN.x / SCREEN.y, EarthCamera::NEAR_PLANE, EarthCamera::FAR_PLANE);
+    proj[1][1] *= -1;
+    return ViewState::create(proj, view, SCREEN);
+}
+
+struct Box {
+    glm::vec2 min, max;
+};
+
+//Screen rectangle of a placed label, the same one CityLabels draws the text in
+static Box labelBox(const LabelPlacer& placer, const PlacedLabel& label) {
+    auto& text = placer.getCandidates()[label.candidate].text;
+    glm::vec2 min = {label.screenPos.x + LabelPlacer::ANCHOR_OFFSET, label.screenPos.y - FONT_SIZE/2};
+    return {min, min + glm::vec2(text.size() * LabelPlacer::GLYPH_WIDTH * FONT_SIZE, FONT_SIZE)};
+}
+
+static bool placed(const std::vector<PlacedLabel>& labels, const LabelPlacer& placer, const std::string& text) {
+    for(auto& l: labels) {
+        if(placer.getCandidates()[l.candidate].text == text)
+            return true;
+    }
+    return false;
+}
+
+//Point of the globe under the pixel
+static glm::vec3 unproject(const ViewState& view, glm::vec2 pixel) {
+    return intersectRayUnitSphere(view.mouseRay(pixel));
+}
+
+static void checkRandomCities() {
+    std::mt19937 rng(5);
+    std::normal_distribution<float> normal;
+    std::uniform_int_distribution<int> length(3, 14), population(1000, 10000000);
+
+    std::vector<LabelCandidate> candidates;
+    for(int i=0; i<2000; ++i) {
+        auto pos = glm::normalize(glm::vec3(normal(rng), normal(rng), normal(rng)));
+        candidates.emplace_back(std::string(length(rng), char('a' + i % 26)), pos, population(rng));
+    }
+    auto camera = glm::normalize(glm::vec3(0.3f, 0.5f, 1.0f));
+    candidates.emplace_back("Antipode", -camera, 100000000); //Most populated, but on the far side
+
+    LabelPlacer placer;
+    placer.setCandidates(std::move(candidates));
+
+    for(float height: {1.5f, 3.0f, EarthCamera::MAX_HEIGHT}) {
+        auto view = makeView(camera, height);
+        auto& labels = placer.place(view, FONT_SIZE);
+        CHECK(labels.size() > 10);
+        CHECK(!placed(labels, placer, "Antipode"));
+
+        for(size_t i=0; i<labels.size(); ++i) {
+            //Only the near hemisphere, and only inside the screen
+            auto pos = placer.getCandidates()[labels[i].candidate].pos;
+            CHECK(glm::dot(pos, view.cameraPos) > 1.0f);
+
+            auto a = labelBox(placer, labels[i]);
+            CHECK(a.min.x >= 0 && a.min.y >= 0 && a.max.x < SCREEN.x && a.max.y < SCREEN.y);
+            for(size_t j=0; j<i; ++j) {
+                auto b = labelBox(placer, labels[j]);
+                bool overlap = a.min.x < b.max.x && b.min.x < a.max.x && a.min.y < b.max.y && b.min.y < a.max.y;
+                CHECK(!overlap);
+            }
+        }
+    }
+}
+
+//A long label whose end is off the right edge of the screen, next to a short one it overlaps. The short one is placed
+//first, and after a small camera move the long one fits on the screen and would win by population
+static void checkPriorityAndStability() {
+    auto camera = glm::vec3(0, 0, 1);
+    auto before = makeView(camera, 1.5f);
+
+    std::string longText(20, 'L');
+    float longWidth = longText.size() * LabelPlacer::GLYPH_WIDTH * FONT_SIZE;
+    glm::vec2 longAnchor = {SCREEN.x + 10 - longWidth - LabelPlacer::ANCHOR_OFFSET, SCREEN.y / 2};
+    glm::vec2 shortAnchor = longAnchor - glm::vec2(5, 0);
+
+    std::vector<LabelCandidate> candidates;
+    candidates.emplace_back("S", unproject(before, shortAnchor), 10);
+    candidates.emplace_back(longText, unproject(before, longAnchor), 1000);
+
+    LabelPlacer placer;
+    placer.setCandidates(candidates);
+    auto& first = placer.place(before, FONT_SIZE);
+    CHECK(placed(first, placer, "S"));
+    CHECK(!placed(first, placer, longText));
+
+    //Turning the camera east slides everything left by a few dozen pixels
+    auto after = makeView(glm::normalize(glm::vec3(0.02f, 0, 1)), 1.5f);
+    glm::vec2 screen[2];
+    uint8_t visible[2];
+    glm::vec3 positions[2] = {candidates[0].pos, candidates[1].pos};
+    after.project(positions, screen, visible);
+    auto shift = shortAnchor.x - screen[0].x;
+    CHECK(visible[0] && visible[1]);
+    CHECK(shift > 10 && shift < 60);
+    CHECK(screen[1].x + LabelPlacer::ANCHOR_OFFSET + longWidth < SCREEN.x);
+
+    //Without history the more populated label wins the conflict
+    LabelPlacer fresh;
+    fresh.setCandidates(candidates);
+    auto& fromScratch = fresh.place(after, FONT_SIZE);
+    CHECK(placed(fromScratch, fresh, longText));
+    CHECK(!placed(fromScratch, fresh, "S"));
+
+    //With history the label that was already on screen keeps its place
+    auto& second = placer.place(after, FONT_SIZE);
+    CHECK(placed(second, placer, "S"));
+    CHECK(!placed(second, placer, longText));
+}
+
+int main() {
+    checkRandomCities();
+    checkPriorityAndStability();
+
+    return failures == 0? 0 : 1;
+}
@@ -0,0 +1,178 @@
+#include "RoutePlanner.hpp"
+#include "Check.hpp"
+
+#include <set>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <random>
+#include <vector>
+
+static const float INF = std::numeric_limits<float>::infinity();
+
+//Plain Dijkstra over the test's own copy of the legs, without landmarks or caching
+struct Reference {
+    std::vector<City> cities;
+    std::set<std::pair<int, int>> legs; //Both directions
+
+    void add(int a, int b) {
+        if(a != b) {
+            legs.emplace(a, b);
+            legs.emplace(b, a);
+        }
+    }
+    void remove(int a, int b) {
+        legs.erase({a, b});
+        legs.erase({b, a});
+    }
+
+    std::vector<double> distances(int from) const {
+        std::vector<std::vector<int>> graph(cities.size());
+        for(auto [a, b]: legs)
+            graph[a].push_back(b);
+
+        std::vector<double> dist(cities.size(), INF);
+        using Entry = std::pair<double, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<>> open;
+        dist[from] = 0;
+        open.emplace(0.0, from);
+        while(!open.empty()) {
+            auto [d, v] = open.top();
+            open.pop();
+            if(d > dist[v])
+                continue;
+            for(auto to: graph[v]) {
+                double nd = d + RoutePlanner::greatCircleDistance(cities[v].coord, cities[to].coord);
+                if(nd < dist[to]) {
+                    dist[to] = nd;
+                    open.emplace(nd, to);
+                }
+            }
+        }
+        return dist;
+    }
+};
+
+//The route must be the shortest one, fly only over existing legs and add up to its distance
+static int countMismatches(const Reference& reference, const std::vector<std::pair<int, int>>& queries, const std::vector<Route>& routes) {
+    int mismatches = 0;
+    std::vector<double> dist;
+    int lastFrom = -1;
+    for(size_t i=0; i<queries.size(); ++i) {
+        auto [from, to] = queries[i];
+        if(from != lastFrom) {
+            dist = reference.distances(from);
+            lastFrom = from;
+        }
+        auto& route = routes[i];
+
+        if(std::isinf(dist[to])) {
+            mismatches += !std::isinf(route.distance) || !route.legs.empty();
+            continue;
+        }
+
+        bool ok = std::abs(route.distance - dist[to]) <= 1e-4 * dist[to] + 1e-2;
+        ok = ok && !route.legs.empty() && route.legs.front() == from && route.legs.back() == to;
+        double length = 0;
+        for(size_t j=1; ok && j<route.legs.size(); ++j) {
+            ok = reference.legs.contains({route.legs[j-1], route.legs[j]});
+            length += RoutePlanner::greatCircleDistance(reference.cities[route.legs[j-1]].coord, reference.cities[route.legs[j]].coord);
+        }
+        ok = ok && std::abs(length - dist[to]) <= 1e-4 * dist[to] + 1e-2;
+        mismatches += !ok;
+    }
+    return mismatches;
+}
+
+int main() {
+    static constexpr int CITY_COUNT = 300;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> lon(-180, 180), lat(-60, 70);
+    std::uniform_int_distribution<int> city(0, CITY_COUNT - 1);
+
+    Reference reference;
+    for(int i=0; i<CITY_COUNT; ++i)
+        reference.cities.push_back(City{"C" + std::to_string(i), 1000 + i, i % 10 == 0, "C" + std::to_string(i / 10), i % 10, {lon(rng), lat(rng)}});
+
+    RoutePlanner planner;
+    planner.load(reference.cities);
+    CHECK(planner.getHubs().size() == CITY_COUNT / 10);
+
+    //Sparse enough that some cities can't reach each other
+    for(int i=0; i<330; ++i) {
+        int a = city(rng), b = city(rng);
+        planner.addRoute(a, b);
+        reference.add(a, b);
+    }
+    int a = reference.legs.begin()->first, b = reference.legs.begin()->second;
+    CHECK(planner.hasRoute(a, b) && planner.hasRoute(b, a));
+    planner.addRoute(a, b); //Duplicates and missing legs are ignored
+    planner.removeRoute(0, 0);
+
+    //Sorted by origin so the reference runs once per origin
+    std::vector<std::pair<int, int>> queries(2000);
+    for(auto& q: queries)
+        q = {city(rng), city(rng)};
+    std::sort(queries.begin(), queries.end());
+
+    auto routes = planner.findRoutes(queries);
+    CHECK(countMismatches(reference, queries, routes) == 0);
+    int unreachable = std::count_if(routes.begin(), routes.end(), [](auto& r){ return std::isinf(r.distance); });
+    CHECK(unreachable > 0 && unreachable < int(routes.size()));
+
+    //The same queries again come from the cache
+    routes.clear();
+    for(auto [from, to]: queries)
+        routes.push_back(planner.findRoute(from, to));
+    CHECK(countMismatches(reference, queries, routes) == 0);
+
+    //Every change invalidates only part of the cache, the cached queries must still see the new network.
+    //Removed legs come from cached routes so the removal bound is exercised, not only unrelated legs
+    int mismatches = 0;
+    for(int round=0; round<40; ++round) {
+        if(round % 2 == 0) {
+            for(int i=0; i<5; ++i) {
+                int a = city(rng), b = city(rng);
+                planner.addRoute(a, b);
+                reference.add(a, b);
+            }
+        } else {
+            for(int i=0; i<5; ++i) {
+                auto& route = routes[std::uniform_int_distribution<size_t>(0, routes.size() - 1)(rng)];
+                if(route.legs.size() < 2)
+                    continue;
+                auto leg = std::uniform_int_distribution<size_t>(1, route.legs.size() - 1)(rng);
+                planner.removeRoute(route.legs[leg - 1], route.legs[leg]);
+                reference.remove(route.legs[leg - 1], route.legs[leg]);
+            }
+        }
+
+        std::vector<std::pair<int, int>> sample;
+        for(int i=0; i<200; ++i)
+            sample.push_back(queries[std::uniform_int_distribution<size_t>(0, queries.size() - 1)(rng)]);
+        std::sort(sample.begin(), sample.end());
+
+        std::vector<Route> sampleRoutes;
+        for(auto [from, to]: sample)
+            sampleRoutes.push_back(planner.findRoute(from, to));
+        mismatches += countMismatches(reference, sample, sampleRoutes);
+
+        routes = planner.findRoutes(queries);
+        mismatches += countMismatches(reference, queries, routes);
+    }
+    CHECK(mismatches == 0);
+
+    //A fresh planner over the final network agrees with the incrementally updated one
+    RoutePlanner fresh;
+    fresh.load(reference.cities);
+    for(auto [a, b]: reference.legs) {
+        if(a < b)
+            fresh.addRoute(a, b);
+    }
+    auto freshRoutes = fresh.findRoutes(queries);
+    CHECK(countMismatches(reference, queries, freshRoutes) == 0);
+
+    return failures == 0? 0 : 1;
+}
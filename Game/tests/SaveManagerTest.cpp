@@ -0,0 +1,104 @@
+#include "SaveManager.hpp"
+#include "Check.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+static bool throws(const std::vector<char>& data) {
+    try {
+        SaveManager::deserialize(data.data(), data.size());
+    } catch(const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+static bool sameCity(const std::optional<City>& a, const std::optional<City>& b) {
+    return a.has_value() == b.has_value() && (!a || (a->country == b->country && a->index == b->index));
+}
+
+int main() {
+    CitySpawner spawner;
+    spawner.load();
+
+    auto cityList = spawner.getCityList();
+    auto codes = std::make_shared<std::vector<std::string>>();
+    for(auto& c: cityList) {
+        if(codes->empty() || codes->back() != c.country)
+            codes->push_back(c.country);
+    }
+    CHECK(codes->size() >= 3);
+
+    spawner.addCountry((*codes)[0]);
+    spawner.addCountry((*codes)[1]);
+    spawner.addCountry((*codes)[2]);
+    for(int i=0; i<2000; ++i)
+        spawner.getRandomCity();
+    spawner.addCountry((*codes)[2]); //Leaves a pending city in the save
+
+    GameSnapshot snapshot;
+    snapshot.countryCodes = codes;
+    snapshot.countryStates.assign(codes->size(), CountryState::LOCKED);
+    snapshot.countryStates[1] = CountryState::BANNED;
+    snapshot.countryStates[2] = CountryState::UNLOCKED;
+    snapshot.spawner = spawner.save(*codes);
+    snapshot.totalTime = 1234.5;
+
+    //Round trip of the whole snapshot
+    auto data = SaveManager::serialize(snapshot);
+    auto loaded = SaveManager::deserialize(data.data(), data.size());
+    CHECK(*loaded.countryCodes == *codes);
+    CHECK(loaded.countryStates == snapshot.countryStates);
+    CHECK(loaded.totalTime == snapshot.totalTime);
+    CHECK(loaded.spawner.generator == snapshot.spawner.generator);
+    CHECK(loaded.spawner.pendingCities.size() == snapshot.spawner.pendingCities.size());
+    CHECK(loaded.spawner.possibleCountries.size() == snapshot.spawner.possibleCountries.size());
+
+    //A restored spawner draws the same cities as the one that was saved
+    CitySpawner restored;
+    restored.load();
+    CHECK(restored.restore(loaded.spawner, *loaded.countryCodes));
+    int mismatches = 0;
+    for(int i=0; i<5000; ++i)
+        mismatches += !sameCity(spawner.getRandomCity(), restored.getRandomCity());
+    CHECK(mismatches == 0);
+
+    //Sections with unknown tags are skipped
+    auto extended = data;
+    uint32_t sections;
+    std::memcpy(&sections, extended.data() + 8, sizeof(sections));
+    sections++;
+    std::memcpy(extended.data() + 8, &sections, sizeof(sections));
+    for(uint32_t word: {99u, 4u, 0xdeadbeefu})
+        extended.insert(extended.end(), reinterpret_cast<char*>(&word), reinterpret_cast<char*>(&word) + sizeof(word));
+    CHECK(!throws(extended));
+
+    //Corrupted or truncated saves are rejected
+    auto badMagic = data;
+    badMagic[0] ^= 1;
+    CHECK(throws(badMagic));
+    for(size_t size: {size_t(0), size_t(11), data.size() / 2, data.size() - 1})
+        CHECK(throws(std::vector<char>(data.begin(), data.begin() + size)));
+
+    //A huge country count is rejected before allocating, the count follows the header and the section tag and size
+    auto badCount = data;
+    uint32_t count = 0xFFFFFFF0;
+    std::memcpy(badCount.data() + 20, &count, sizeof(count));
+    CHECK(throws(badCount));
+
+    auto badCountry = snapshot;
+    badCountry.spawner.pendingCities.push_back(CityRef{uint16_t(codes->size()), 0});
+    CHECK(throws(SaveManager::serialize(badCountry)));
+
+    //A city that isn't in the loaded airports is rejected by restore without touching the spawner
+    auto badCity = snapshot;
+    badCity.spawner.pendingCities.push_back(CityRef{0, 60000});
+    auto badCityData = SaveManager::serialize(badCity);
+    auto badCityLoaded = SaveManager::deserialize(badCityData.data(), badCityData.size());
+    auto before = SaveManager::serialize(GameSnapshot{codes, snapshot.countryStates, restored.save(*codes), 0});
+    CHECK(!restored.restore(badCityLoaded.spawner, *badCityLoaded.countryCodes));
+    auto after = SaveManager::serialize(GameSnapshot{codes, snapshot.countryStates, restored.save(*codes), 0});
+    CHECK(before == after);
+
+    return failures == 0? 0 : 1;
+}
@@ -0,0 +1,223 @@
+#include "ViewState.hpp"
+#include "EarthCamera.hpp"
+#include "Check.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+static const glm::vec2 SCREEN = {1280, 720};
+
+//Same matrices EarthCamera::update builds
+static ViewState makeView(glm::vec3 normPos, float height) {
+    auto view = glm::lookAt(height * normPos, glm::vec3(0.0f), EarthCamera::UP);
+    auto proj = glm::perspective(glm::radians(45.0f), SCREEN.x / SCREEN.y, EarthCamera::NEAR_PLANE, EarthCamera::FAR_PLANE);
+    proj[1][1] *= -1;
+    return ViewState::create(proj, view, SCREEN);
+}
+
+//What EarthCamera::mouseRay did before the view state, inverting the matrix on every call
+static Ray uncachedMouseRay(const ViewState& view, glm::vec2 mousePos) {
+    glm::vec2 ndc = (mousePos / view.screenSize - 0.5f) * 2.0f;
+    glm::mat4 invVP = glm::inverse(view.viewProj);
+    glm::vec4 rayStart = invVP * glm::vec4(ndc.x, ndc.y, -1.0f, 1.0f);
+    rayStart /= rayStart.w;
+    glm::vec4 rayEnd = invVP * glm::vec4(ndc.x, ndc.y, 0.0f, 1.0f);
+    rayEnd /= rayEnd.w;
+    return Ray {rayStart, glm::normalize(glm::vec3(rayEnd - rayStart))};
+}
+
+//The per city projection CityLabels did before the batched one
+static bool scalarProject(const ViewState& view, glm::vec3 p, glm::vec2& screen) {
+    auto clip = view.viewProj * glm::vec4(p, 1.0f);
+    auto ndc = glm::vec2(clip.x, clip.y) / clip.w;
+    screen = (ndc * 0.5f + 0.5f) * view.screenSize;
+    return glm::dot(p, view.cameraPos) > 1.0f && clip.w > 0 && std::abs(ndc.x) <= 1 && std::abs(ndc.y) <= 1;
+}
+
+//How far from tangent a ray is, b*b - c cancels near 0 so float rounding can flip hit and miss there.
+//From the farthest camera one pixel is around 1e-2
+static float grazing(Ray r) {
+    float b = glm::dot(r.origin, r.direction);
+    return std::abs(b*b - (glm::dot(r.origin, r.origin) - 1));
+}
+
+static void checkPicking(const ViewState& view, const std::vector<glm::vec2>& mousePos) {
+    RayBatch rays;
+    view.mouseRays(mousePos, rays);
+    CHECK(rays.size() == mousePos.size());
+
+    std::vector<glm::vec3> points(mousePos.size());
+    std::vector<uint8_t> hit(mousePos.size());
+    intersectRaysUnitSphere(rays, points, hit);
+
+    int hits = 0, badRays = 0, badHits = 0, badPoints = 0;
+    for(size_t i=0; i<mousePos.size(); ++i) {
+        auto expectedRay = view.mouseRay(mousePos[i]);
+        auto uncachedRay = uncachedMouseRay(view, mousePos[i]);
+        auto ray = rays.get(i);
+        badRays += glm::length(ray.origin - expectedRay.origin) > 1e-4f || glm::length(ray.direction - expectedRay.direction) > 1e-4f;
+        badRays += glm::length(uncachedRay.origin - expectedRay.origin) > 1e-4f || glm::length(uncachedRay.direction - expectedRay.direction) > 1e-4f;
+
+        auto expected = intersectRayUnitSphere(expectedRay);
+        bool expectedHit = expected != glm::vec3(0, 0, 0);
+        hits += expectedHit;
+        if(bool(hit[i]) != expectedHit) {
+            badHits += grazing(expectedRay) > 1e-3f;
+            continue;
+        }
+        if(!expectedHit)
+            continue;
+
+        //The float rounding in b * b - c slides the hit point along the ray (a few 1e-4 from far away, for the scalar
+        //path too), which barely moves it on screen, so compare where it lands and that it stays on the sphere
+        glm::vec2 a, b;
+        scalarProject(view, points[i], a);
+        scalarProject(view, expected, b);
+        badPoints += glm::length(a - b) > 0.05f || std::abs(glm::length(points[i]) - 1) > 1e-3f;
+    }
+
+    CHECK(hits > 0);
+    CHECK(badRays == 0);
+    CHECK(badHits == 0);
+    CHECK(badPoints == 0);
+}
+
+static void checkProjection(const ViewState& view, const std::vector<glm::vec3>& points) {
+    std::vector<glm::vec2> screen(points.size());
+    std::vector<uint8_t> visible(points.size());
+    view.project(points, screen, visible);
+
+    int visibleCount = 0, badVisible = 0, badScreen = 0;
+    for(size_t i=0; i<points.size(); ++i) {
+        glm::vec2 expected;
+        bool expectedVisible = scalarProject(view, points[i], expected);
+        visibleCount += expectedVisible;
+
+        bool onHorizon = std::abs(glm::dot(points[i], view.cameraPos) - 1.0f) < 1e-5f;
+        badVisible += bool(visible[i]) != expectedVisible && !onHorizon;
+        if(expectedVisible)
+            badScreen += glm::length(screen[i] - expected) > 1e-2f;
+    }
+
+    CHECK(visibleCount > 0);
+    CHECK(badVisible == 0);
+    CHECK(badScreen == 0);
+}
+
+static void checkFrustum(const ViewState& view, const std::vector<glm::vec3>& points) {
+    for(auto& p: view.frustum)
+        CHECK(std::abs(glm::length(glm::vec3(p)) - 1) < 1e-5f);
+
+    //The camera is behind the near plane by its distance, and the far plane is as far in front
+    auto distance = [&view](int plane, glm::vec3 p){ return glm::dot(glm::vec3(view.frustum[plane]), p) + view.frustum[plane].w; };
+    CHECK(std::abs(distance(4, view.cameraPos) + EarthCamera::NEAR_PLANE) < 1e-4f);
+    CHECK(std::abs(distance(5, view.cameraPos) - EarthCamera::FAR_PLANE) < 1e-3f);
+
+    //A point passes the planes exactly when its clip coordinates are inside the clip volume
+    int insideCount = 0, mismatches = 0;
+    for(auto p: points) {
+        auto clip = view.viewProj * glm::vec4(p, 1.0f);
+        bool inside = std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && clip.z >= 0 && clip.z <= clip.w;
+        insideCount += inside;
+        float closest = INFINITY;
+        for(int i=0; i<6; ++i)
+            closest = std::min(closest, std::abs(distance(i, p)));
+        mismatches += closest > 1e-4f && view.isSphereVisible(p, 0) != inside;
+    }
+    CHECK(insideCount > 0 && insideCount < int(points.size()));
+    CHECK(mismatches == 0);
+
+    auto forward = -glm::normalize(view.cameraPos);
+    CHECK(view.isSphereVisible({0, 0, 0}, 1));
+    CHECK(!view.isSphereVisible(view.cameraPos - forward, 0.5f));                                //Behind the camera
+    CHECK(view.isSphereVisible(view.cameraPos - forward * 0.5f, 0.6f));                          //Around it
+    CHECK(!view.isSphereVisible(view.cameraPos + forward * (EarthCamera::FAR_PLANE + 1), 0.5f)); //Past the far plane
+}
+
+int main() {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(-1, 1), x(0, SCREEN.x), y(0, SCREEN.y);
+    auto randomDir = [&]() {
+        glm::vec3 v;
+        do v = {unit(rng), unit(rng), unit(rng)}; while(glm::length(v) < 0.1f);
+        return glm::normalize(v);
+    };
+
+    for(float height: {EarthCamera::MIN_HEIGHT, 1.5f, 3.0f, EarthCamera::MAX_HEIGHT}) {
+        for(int c=0; c<4; ++c) {
+            //A random camera that keeps within the latitudes EarthCamera allows so lookAt's up stays valid
+            auto normPos = randomDir();
+            normPos.y *= 0.8f;
+            auto view = makeView(glm::normalize(normPos), height);
+
+            //Not a multiple of 4 so the scalar tails run too
+            std::vector<glm::vec2> mousePos(4099);
+            for(auto& p: mousePos)
+                p = {x(rng), y(rng)};
+
+            //Pixels on the silhouette, where the rays are tangent to the sphere
+            auto camDir = glm::normalize(view.cameraPos);
+            auto side = glm::normalize(glm::cross(camDir, EarthCamera::UP));
+            auto up = glm::cross(side, camDir);
+            float camDistance = glm::length(view.cameraPos);
+            auto center = camDir / camDistance;
+            float radius = std::sqrt(1 - 1 / (camDistance * camDistance));
+            std::vector<glm::vec3> silhouette;
+            for(int i=0; i<361; ++i) {
+                float a = glm::radians(float(i));
+                silhouette.push_back(center + radius * (std::cos(a) * side + std::sin(a) * up));
+
+                glm::vec2 pixel;
+                scalarProject(view, silhouette.back(), pixel);
+                if(pixel.x >= 0 && pixel.y >= 0 && pixel.x < SCREEN.x && pixel.y < SCREEN.y)
+                    mousePos.push_back(pixel);
+            }
+            checkPicking(view, mousePos);
+
+            std::vector<glm::vec3> points(4099);
+            for(auto& p: points)
+                p = randomDir();
+            points.insert(points.end(), silhouette.begin(), silhouette.end());
+            checkProjection(view, points);
+
+            for(auto& p: points)
+                p = glm::vec3(unit(rng), unit(rng), unit(rng)) * (EarthCamera::MAX_HEIGHT + 1);
+            checkFrustum(view, points);
+        }
+    }
+
+    //Rays built right at, just inside and just outside the tangent from a point at distance 3
+    RayBatch rays;
+    std::vector<Ray> expected;
+    for(float offset: {-1e-3f, 0.0f, 1e-3f}) {
+        float angle = std::asin(1.0f / 3.0f) + offset;
+        for(int i=0; i<7; ++i) {
+            float around = glm::radians(360.0f * i / 7);
+            auto perpendicular = std::cos(around) * glm::vec3(1, 0, 0) + std::sin(around) * glm::vec3(0, 1, 0);
+            expected.push_back({{0, 0, 3}, glm::normalize(-std::cos(angle) * glm::vec3(0, 0, 1) + std::sin(angle) * perpendicular)});
+        }
+    }
+    rays.resize(expected.size());
+    for(size_t i=0; i<expected.size(); ++i)
+        rays.set(i, expected[i]);
+
+    std::vector<glm::vec3> points(expected.size());
+    std::vector<uint8_t> hit(expected.size());
+    intersectRaysUnitSphere(rays, points, hit);
+    for(size_t i=0; i<expected.size(); ++i) {
+        auto q = intersectRayUnitSphere(expected[i]);
+        if(i < 7)
+            CHECK(hit[i] && q != glm::vec3(0, 0, 0));   //Inside the tangent
+        if(i >= 14)
+            CHECK(!hit[i] && q == glm::vec3(0, 0, 0));  //Outside the tangent
+        if(hit[i] && q != glm::vec3(0, 0, 0))
+            CHECK(std::abs(glm::length(points[i]) - 1) < 1e-3f && glm::length(glm::cross(points[i] - expected[i].origin, expected[i].direction)) < 1e-4f);
+    }
+
+    return failures == 0? 0 : 1;
+}